@@ -0,0 +1,115 @@
+#include "AssetRegistry.h"
+#include "model.h"
+#include "GLState.h"
+#include "MemoryTracker.h"
+#include "TextureStreamer.h"
+
+std::unordered_map<std::string, std::weak_ptr<TextureAsset>> AssetRegistry::textures;
+std::unordered_map<std::string, std::weak_ptr<Mesh>> AssetRegistry::meshes;
+std::unordered_map<std::string, std::weak_ptr<const ModelAsset>> AssetRegistry::models;
+unsigned AssetRegistry::hits = 0;
+unsigned AssetRegistry::misses = 0;
+bool AssetRegistry::hasContext = true;
+
+namespace
+{
+    template<typename T>
+    size_t countLive(const std::unordered_map<std::string, std::weak_ptr<T>> &entries)
+    {
+        size_t live = 0;
+        for(const auto& entry : entries)
+            live += entry.second.expired() ? 0 : 1;
+        return live;
+    }
+}
+
+TextureAsset::~TextureAsset()
+{
+    if (id && AssetRegistry::HasContext())
+    {
+        TextureStreamer::Cancel(id);
+        GLState::DeleteTextures(1, &id);
+        MemoryTracker::Untrack(MEMORY_TEXTURES, MEMORY_OBJECT_TEXTURE, id);
+    }
+}
+
+std::shared_ptr<TextureAsset> AssetRegistry::GetTexture(const std::string &path, const std::string &directory/* = ""*/, std::shared_ptr<const TextureImage> image/* = nullptr*/)
+{
+    const std::string key = directory.empty() ? path : directory + '/' + path;
+    std::weak_ptr<TextureAsset>& entry = textures[key];
+    if (std::shared_ptr<TextureAsset> texture = entry.lock())
+    {
+        ++hits;
+        return texture;
+    }
+
+    ++misses;
+    auto texture = std::make_shared<TextureAsset>();
+    texture->id = image ? TextureStreamer::Create(std::move(image)) : TextureFromFile(path.c_str(), directory);
+    texture->path = path;
+    entry = texture;
+    return texture;
+}
+
+std::string AssetRegistry::ModelKey(const std::string &path, const ImportOptions &options)
+{
+    return path + (options.optimize ? "|optimized" : "|raw") + (options.generateLods ? "|lods" : "") + (options.keepCpuData ? "|cpu" : "") + (options.batchStatic ? "|batched" : "");
+}
+
+std::shared_ptr<const ModelAsset> AssetRegistry::GetModel(const std::string &path, const ImportOptions &options)
+{
+    if (std::shared_ptr<const ModelAsset> model = FindModel(path, options))
+        return model;
+    std::shared_ptr<const ModelAsset> model = Model::Import(path, options);
+    AddModel(path, options, model);
+    return model;
+}
+
+std::shared_ptr<const ModelAsset> AssetRegistry::FindModel(const std::string &path, const ImportOptions &options)
+{
+    if (!options.shared)
+        return nullptr;
+    auto entry = models.find(ModelKey(path, options));
+    std::shared_ptr<const ModelAsset> model = entry != models.end() ? entry->second.lock() : nullptr;
+    if (model)
+        ++hits;
+    return model;
+}
+
+void AssetRegistry::AddModel(const std::string &path, const ImportOptions &options, const std::shared_ptr<const ModelAsset> &model)
+{
+    ++misses;
+    if (options.shared)
+        models[ModelKey(path, options)] = model;
+}
+
+std::shared_ptr<Mesh> AssetRegistry::GetMesh(const std::string &key, const std::function<Mesh()> &create)
+{
+    std::weak_ptr<Mesh>& entry = meshes[key];
+    if (std::shared_ptr<Mesh> mesh = entry.lock())
+    {
+        ++hits;
+        return mesh;
+    }
+
+    ++misses;
+    auto mesh = std::make_shared<Mesh>(create());
+    entry = mesh;
+    return mesh;
+}
+
+AssetRegistryStats AssetRegistry::Stats()
+{
+    AssetRegistryStats stats;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.liveTextures = countLive(textures);
+    stats.liveMeshes = countLive(meshes);
+    stats.liveModels = countLive(models);
+    return stats;
+}
+
+void AssetRegistry::OnContextDestroyed()
+{
+    hasContext = false;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mesh.h"
+#include "MeshOptimizer.h"
+#include "TextureImage.h"
+
+// GPU texture shared by every material sampling the same file, deleted with its last user
+struct TextureAsset
+{
+    GLuint id = 0;
+    std::string path;
+
+    TextureAsset() = default;
+    TextureAsset(const TextureAsset&) = delete;
+    TextureAsset& operator=(const TextureAsset&) = delete;
+    ~TextureAsset();
+};
+
+// Meshes imported from one file, shared by every model loading it with the same options
+struct ModelAsset
+{
+    std::vector<std::shared_ptr<Mesh>> meshes;
+    std::string directory;
+};
+
+struct AssetRegistryStats
+{
+    unsigned hits = 0;
+    unsigned misses = 0;
+    size_t liveTextures = 0;
+    size_t liveMeshes = 0; // standalone meshes, see GetMesh
+    size_t liveModels = 0;
+};
+
+// Process-wide cache of imported assets. Entries only hold weak references,
+// an asset is freed as soon as the last handle to it is released.
+class AssetRegistry
+{
+public:
+    // `image` is streamed in on a miss if given, the file is decoded otherwise
+    static std::shared_ptr<TextureAsset> GetTexture(const std::string &path, const std::string &directory = "", std::shared_ptr<const TextureImage> image = nullptr);
+    // Imports the file on a miss. Options that opt out of sharing always import a private copy.
+    static std::shared_ptr<const ModelAsset> GetModel(const std::string &path, const ImportOptions &options);
+    // For models imported elsewhere, e.g. by SceneLoader. FindModel returns null on a miss.
+    static std::shared_ptr<const ModelAsset> FindModel(const std::string &path, const ImportOptions &options);
+    static void AddModel(const std::string &path, const ImportOptions &options, const std::shared_ptr<const ModelAsset> &model);
+    // Equal for imports that may share their result
+    static std::string ModelKey(const std::string &path, const ImportOptions &options);
+    // Meshes built in code, `create` runs on a miss
+    static std::shared_ptr<Mesh> GetMesh(const std::string &key, const std::function<Mesh()> &create);
+
+    static AssetRegistryStats Stats();
+
+    // GL objects of assets released after this are leaked instead of deleted without a context
+    static void OnContextDestroyed();
+    static bool HasContext() { return hasContext; }
+
+private:
+    static std::unordered_map<std::string, std::weak_ptr<TextureAsset>> textures;
+    static std::unordered_map<std::string, std::weak_ptr<Mesh>> meshes;
+    static std::unordered_map<std::string, std::weak_ptr<const ModelAsset>> models;
+    static unsigned hits;
+    static unsigned misses;
+    static bool hasContext;
+};
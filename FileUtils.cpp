@@ -0,0 +1,68 @@
+#include "FileUtils.h"
+#include <atomic>
+#include <fstream>
+#include <cstdio>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+bool EnsureDirectory(const std::string &path)
+{
+    for(size_t pos = path.find('/'); ; pos = path.find('/', pos + 1))
+    {
+        std::string dir = path.substr(0, pos);
+        if (!dir.empty())
+        {
+#ifdef _WIN32
+            int result = _mkdir(dir.c_str());
+#else
+            int result = mkdir(dir.c_str(), 0755);
+#endif
+            if (result != 0 && errno != EEXIST)
+                return false;
+        }
+        if (pos == std::string::npos)
+            return true;
+    }
+}
+
+bool ReadFile(const std::string &path, std::vector<char> &data)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return false;
+    std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    data.resize((size_t)size);
+    return size == 0 || (bool)file.read(data.data(), size);
+}
+
+bool WriteFile(const std::string &path, const void *data, size_t size)
+{
+    // numbered, so that threads writing the same file don't truncate each other's copy
+    static std::atomic<unsigned> writeCount{0};
+    const std::string tmpPath = path + "." + std::to_string(++writeCount) + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+        file.write(static_cast<const char*>(data), (std::streamsize)size);
+        if (!file)
+        {
+            file.close();
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+    std::remove(path.c_str());
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
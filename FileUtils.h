@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+bool EnsureDirectory(const std::string &path);
+bool ReadFile(const std::string &path, std::vector<char> &data);
+// writes to a temporary file first so a crash never leaves a truncated file behind
+bool WriteFile(const std::string &path, const void *data, size_t size);
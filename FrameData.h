@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include "UniformBuffer.h"
+
+// Mirrors the FrameData block in shaders/frame_data.glsl, uploaded once per frame
+struct FrameData
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 viewPos;
+    float time;
+    glm::vec2 resolution;
+    glm::vec2 padding;
+};
+
+CHECK_STD140_OFFSET(FrameData, view, 0);
+CHECK_STD140_OFFSET(FrameData, projection, 64);
+CHECK_STD140_OFFSET(FrameData, viewPos, 128);
+CHECK_STD140_OFFSET(FrameData, time, 140);
+CHECK_STD140_OFFSET(FrameData, resolution, 144);
+static_assert(sizeof(FrameData) == 160, "FrameData doesn't match the std140 layout");
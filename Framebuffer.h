@@ -1,19 +1,21 @@
-#pragma once
-
-#include <glad/glad.h>
-#include <glm/glm.hpp>
-
-class Framebuffer
-{
-    GLuint fbo;
-    GLuint rbo;
-    GLuint textureID;
-	GLuint quadVAO, quadVBO;
-
-    glm::vec4 clearColor;
-
-public:
-    Framebuffer(GLsizei width, GLsizei height, glm::vec4 color);
-    void Use();
-    void Draw();
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+class Framebuffer
+{
+    GLuint fbo;
+    GLuint rbo;
+    GLuint textureID;
+	GLuint quadVAO, quadVBO;
+
+    glm::vec4 clearColor;
+
+public:
+    Framebuffer(GLsizei width, GLsizei height, glm::vec4 color);
+    void Use();
+    void Draw();
+    // binds and clears the default framebuffer without presenting anything
+    void Unbind();
 };
\ No newline at end of file
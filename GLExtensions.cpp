@@ -0,0 +1,51 @@
+#include "GLExtensions.h"
+#include <cstring>
+
+namespace GLExt
+{
+    bool programBinary = false;
+    GetProgramBinaryProc GetProgramBinary = nullptr;
+    ProgramBinaryProc ProgramBinary = nullptr;
+    ProgramParameteriProc ProgramParameteri = nullptr;
+    bool parallelShaderCompile = false;
+    MaxShaderCompilerThreadsProc MaxShaderCompilerThreads = nullptr;
+    bool textureCompressionS3TC = false;
+
+    bool HasExtension(const char *name)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for(GLint i = 0; i < count; ++i)
+        {
+            const char *extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+            if (extension && std::strcmp(extension, name) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    void Load(GLADloadproc load)
+    {
+        const bool gl41 = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 1);
+        if (gl41 || HasExtension("GL_ARB_get_program_binary"))
+        {
+            GetProgramBinary = (GetProgramBinaryProc)load("glGetProgramBinary");
+            ProgramBinary = (ProgramBinaryProc)load("glProgramBinary");
+            ProgramParameteri = (ProgramParameteriProc)load("glProgramParameteri");
+
+            GLint formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            programBinary = GetProgramBinary && ProgramBinary && ProgramParameteri && formats > 0;
+        }
+
+        if (HasExtension("GL_KHR_parallel_shader_compile"))
+            MaxShaderCompilerThreads = (MaxShaderCompilerThreadsProc)load("glMaxShaderCompilerThreadsKHR");
+        else if (HasExtension("GL_ARB_parallel_shader_compile"))
+            MaxShaderCompilerThreads = (MaxShaderCompilerThreadsProc)load("glMaxShaderCompilerThreadsARB");
+        parallelShaderCompile = MaxShaderCompilerThreads != nullptr;
+        if (parallelShaderCompile)
+            MaxShaderCompilerThreads(0xFFFFFFFF); // let the driver pick
+
+        textureCompressionS3TC = HasExtension("GL_EXT_texture_compression_s3tc");
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Entry points newer than the GL 3.3 core profile glad was generated for.
+// They're optional: check the flags before calling.
+
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace GLExt
+{
+    typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+    typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+    typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+    typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+
+    // GL 4.1 or ARB_get_program_binary with at least one binary format
+    extern bool programBinary;
+    extern GetProgramBinaryProc GetProgramBinary;
+    extern ProgramBinaryProc ProgramBinary;
+    extern ProgramParameteriProc ProgramParameteri;
+
+    // KHR or ARB_parallel_shader_compile: GL_COMPLETION_STATUS_KHR can be polled without blocking
+    extern bool parallelShaderCompile;
+    extern MaxShaderCompilerThreadsProc MaxShaderCompilerThreads;
+
+    // EXT_texture_compression_s3tc: BC1 and BC3 textures. BC4 and BC5 (RGTC) are core.
+    extern bool textureCompressionS3TC;
+
+    bool HasExtension(const char *name);
+    // call right after gladLoadGLLoader with the same loader
+    void Load(GLADloadproc load);
+}
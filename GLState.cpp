@@ -0,0 +1,218 @@
+#include "GLState.h"
+
+namespace
+{
+    const GLuint UNKNOWN = ~0u;
+    const int MAX_TEXTURE_UNITS = 32;
+    const GLenum TRACKED_CAPS[] = {GL_DEPTH_TEST, GL_STENCIL_TEST, GL_CULL_FACE, GL_BLEND};
+    const int TRACKED_CAPS_COUNT = sizeof(TRACKED_CAPS) / sizeof(TRACKED_CAPS[0]);
+    enum TextureTarget { TARGET_2D, TARGET_CUBE_MAP, TARGETS_COUNT };
+
+    struct State
+    {
+        GLuint program = UNKNOWN;
+        GLuint vao = UNKNOWN;
+        int caps[TRACKED_CAPS_COUNT]; // -1 unknown, 0 disabled, 1 enabled
+        GLenum stencilFunc = GL_NONE;
+        GLint stencilRef = 0;
+        GLuint stencilFuncMask = 0;
+        GLuint stencilMask = 0;
+        bool stencilMaskKnown = false;
+        int depthMask = -1;
+        GLenum activeTexture = GL_NONE;
+        GLuint textures[MAX_TEXTURE_UNITS][TARGETS_COUNT];
+        GLuint framebuffer = UNKNOWN;
+
+        State()
+        {
+            for(int &cap : caps)
+                cap = -1;
+            for(auto &unit : textures)
+                for(GLuint &texture : unit)
+                    texture = UNKNOWN;
+        }
+    };
+
+    State state;
+    GLState::Stats currentStats;
+    GLState::Stats lastStats;
+
+    // returns true if the call has to be issued
+    bool track(GLState::Call call, bool changed)
+    {
+        if (changed)
+            ++currentStats.issued[call];
+        else
+            ++currentStats.skipped[call];
+        return changed;
+    }
+
+    int capIndex(GLenum cap)
+    {
+        for(int i = 0; i < TRACKED_CAPS_COUNT; ++i)
+            if (TRACKED_CAPS[i] == cap)
+                return i;
+        return -1;
+    }
+
+    int targetIndex(GLenum target)
+    {
+        if (target == GL_TEXTURE_2D)
+            return TARGET_2D;
+        if (target == GL_TEXTURE_CUBE_MAP)
+            return TARGET_CUBE_MAP;
+        return -1;
+    }
+}
+
+void GLState::UseProgram(GLuint program)
+{
+    if (track(USE_PROGRAM, state.program != program))
+    {
+        glUseProgram(program);
+        state.program = program;
+    }
+}
+
+void GLState::BindVertexArray(GLuint vao)
+{
+    if (track(BIND_VERTEX_ARRAY, state.vao != vao))
+    {
+        glBindVertexArray(vao);
+        state.vao = vao;
+    }
+}
+
+void GLState::Set(GLenum cap, bool enabled)
+{
+    int index = capIndex(cap);
+    if (track(CAPABILITY, index == -1 || state.caps[index] != (int)enabled))
+    {
+        if (enabled)
+            glEnable(cap);
+        else
+            glDisable(cap);
+        if (index != -1)
+            state.caps[index] = (int)enabled;
+    }
+}
+
+void GLState::StencilFunc(GLenum func, GLint ref, GLuint mask)
+{
+    if (track(STENCIL_FUNC, state.stencilFunc != func || state.stencilRef != ref || state.stencilFuncMask != mask))
+    {
+        glStencilFunc(func, ref, mask);
+        state.stencilFunc = func;
+        state.stencilRef = ref;
+        state.stencilFuncMask = mask;
+    }
+}
+
+void GLState::StencilMask(GLuint mask)
+{
+    if (track(STENCIL_MASK, !state.stencilMaskKnown || state.stencilMask != mask))
+    {
+        glStencilMask(mask);
+        state.stencilMask = mask;
+        state.stencilMaskKnown = true;
+    }
+}
+
+void GLState::DepthMask(GLboolean flag)
+{
+    if (track(DEPTH_MASK, state.depthMask != (int)flag))
+    {
+        glDepthMask(flag);
+        state.depthMask = (int)flag;
+    }
+}
+
+void GLState::ActiveTexture(GLenum unit)
+{
+    if (track(ACTIVE_TEXTURE, state.activeTexture != unit))
+    {
+        glActiveTexture(unit);
+        state.activeTexture = unit;
+    }
+}
+
+void GLState::BindTexture(GLenum target, GLuint texture)
+{
+    int unit = state.activeTexture == GL_NONE ? -1 : int(state.activeTexture - GL_TEXTURE0);
+    int targetId = targetIndex(target);
+    if (unit < 0 || unit >= MAX_TEXTURE_UNITS || targetId == -1)
+    {
+        track(BIND_TEXTURE, true);
+        glBindTexture(target, texture);
+        return;
+    }
+
+    GLuint &bound = state.textures[unit][targetId];
+    if (track(BIND_TEXTURE, bound != texture))
+    {
+        glBindTexture(target, texture);
+        bound = texture;
+    }
+}
+
+void GLState::BindFramebuffer(GLuint fbo)
+{
+    if (track(BIND_FRAMEBUFFER, state.framebuffer != fbo))
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        state.framebuffer = fbo;
+    }
+}
+
+void GLState::DeleteTextures(GLsizei count, const GLuint *textures)
+{
+    glDeleteTextures(count, textures);
+    for(GLsizei i = 0; i < count; ++i)
+        for(auto &unit : state.textures)
+            for(GLuint &bound : unit)
+                if (bound == textures[i])
+                    bound = 0;
+}
+
+void GLState::DeleteVertexArrays(GLsizei count, const GLuint *vaos)
+{
+    glDeleteVertexArrays(count, vaos);
+    for(GLsizei i = 0; i < count; ++i)
+        if (state.vao == vaos[i])
+            state.vao = 0;
+}
+
+void GLState::Invalidate()
+{
+    state = State{};
+}
+
+void GLState::BeginFrame()
+{
+    lastStats = currentStats;
+    currentStats = Stats{};
+}
+
+const GLState::Stats& GLState::LastFrameStats()
+{
+    return lastStats;
+}
+
+const char* GLState::CallName(Call call)
+{
+    switch (call)
+    {
+    case USE_PROGRAM: return "UseProgram";
+    case BIND_VERTEX_ARRAY: return "BindVertexArray";
+    case CAPABILITY: return "Enable/Disable";
+    case STENCIL_FUNC: return "StencilFunc";
+    case STENCIL_MASK: return "StencilMask";
+    case DEPTH_MASK: return "DepthMask";
+    case ACTIVE_TEXTURE: return "ActiveTexture";
+    case BIND_TEXTURE: return "BindTexture";
+    case BIND_FRAMEBUFFER: return "BindFramebuffer";
+
+    default:
+        return "";
+    }
+}
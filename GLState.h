@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Shadow copy of the GL state touched by the render loop. Calls that wouldn't
+// change the bound state are dropped. Code that changes this state with raw gl*
+// calls must call Invalidate() afterwards.
+class GLState
+{
+public:
+    enum Call
+    {
+        USE_PROGRAM,
+        BIND_VERTEX_ARRAY,
+        CAPABILITY,
+        STENCIL_FUNC,
+        STENCIL_MASK,
+        DEPTH_MASK,
+        ACTIVE_TEXTURE,
+        BIND_TEXTURE,
+        BIND_FRAMEBUFFER,
+        CALLS_COUNT
+    };
+
+    struct Stats
+    {
+        unsigned issued[CALLS_COUNT] = {};
+        unsigned skipped[CALLS_COUNT] = {};
+    };
+
+    static void UseProgram(GLuint program);
+    static void BindVertexArray(GLuint vao);
+    static void Enable(GLenum cap) { Set(cap, true); }
+    static void Disable(GLenum cap) { Set(cap, false); }
+    static void Set(GLenum cap, bool enabled);
+    static void StencilFunc(GLenum func, GLint ref, GLuint mask);
+    static void StencilMask(GLuint mask);
+    static void DepthMask(GLboolean flag);
+    static void ActiveTexture(GLenum unit);
+    static void BindTexture(GLenum target, GLuint texture);
+    static void BindFramebuffer(GLuint fbo);
+
+    // GL unbinds deleted objects, these forget them too so that a reused name gets bound again
+    static void DeleteTextures(GLsizei count, const GLuint *textures);
+    static void DeleteVertexArrays(GLsizei count, const GLuint *vaos);
+
+    static void Invalidate();
+
+    // Call once at the start of a frame, LastFrameStats then holds the counts of the previous frame
+    static void BeginFrame();
+    static const Stats& LastFrameStats();
+    static const char* CallName(Call call);
+};
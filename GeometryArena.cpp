@@ -0,0 +1,302 @@
+#include "GeometryArena.h"
+#include "GLState.h"
+#include "mesh.h"
+#include "MemoryTracker.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    const size_t INITIAL_VERTICES = 1 << 16;
+    const size_t INITIAL_INDEX_BYTES = 1 << 20;
+
+    struct FormatBuffers
+    {
+        GLuint VAO = 0;
+        GLuint VBO = 0;
+        GLuint EBO = 0;
+        RangeAllocator vertices; // in vertices, so that offsets are valid base vertices
+        RangeAllocator indices;  // in bytes
+        unsigned allocations = 0;
+    };
+
+    FormatBuffers formats[VERTEX_FORMATS_COUNT];
+    const char *BUFFER_NAMES[VERTEX_FORMATS_COUNT][2] = {{"vertices", "indices"}, {"packed vertices", "packed indices"}};
+    GLuint instanceVBO = 0;
+    size_t instanceBytes = 0;
+
+    void setupInstanceAttributes()
+    {
+        if (!instanceVBO)
+        {
+            // never empty, enabled arrays must have something behind them even when no shader reads them
+            glGenBuffers(1, &instanceVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+            instanceBytes = sizeof(InstanceData);
+            MemoryTracker::Track(MEMORY_GEOMETRY, MEMORY_OBJECT_BUFFER, instanceVBO, "instance data", instanceBytes);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        for(int column = 0; column < 4; ++column)
+        {
+            glEnableVertexAttribArray(3 + column);
+            glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(3 + column, 1);
+        }
+        glEnableVertexAttribArray(7);
+        glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, color));
+        glVertexAttribDivisor(7, 1);
+        glEnableVertexAttribArray(8);
+        glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, material));
+        glVertexAttribDivisor(8, 1);
+    }
+
+    void setupAttributes(VertexFormat format)
+    {
+        switch (format)
+        {
+        case VERTEX_FORMAT_PACKED:
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Position));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Normal));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, TexCoords));
+            break;
+        case VERTEX_FORMAT_DEFAULT:
+        default:
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+            break;
+        }
+    }
+
+    // Reallocates `buffer` with `newSize` bytes, keeping the first `oldSize`
+    void growBuffer(GLuint &buffer, size_t oldSize, size_t newSize, const char *name)
+    {
+        GLuint grown;
+        glGenBuffers(1, &grown);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+        glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_STATIC_DRAW);
+        if (buffer)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+            glDeleteBuffers(1, &buffer);
+            MemoryTracker::Untrack(MEMORY_GEOMETRY, MEMORY_OBJECT_BUFFER, buffer);
+        }
+        buffer = grown;
+        MemoryTracker::Track(MEMORY_GEOMETRY, MEMORY_OBJECT_BUFFER, buffer, name, newSize);
+    }
+
+    // The VAO captures both buffers, so it is pointed at them again after any growth
+    void rebindVertexArray(VertexFormat format)
+    {
+        FormatBuffers& buffers = formats[format];
+        if (!buffers.VAO)
+            glGenVertexArrays(1, &buffers.VAO);
+        GLState::BindVertexArray(buffers.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, buffers.VBO);
+        setupAttributes(format);
+        setupInstanceAttributes();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.EBO);
+    }
+
+    size_t allocateGrowing(RangeAllocator &allocator, GLuint &buffer, const char *name, size_t unitSize, size_t initialCapacity, size_t size, size_t alignment, bool &grew)
+    {
+        size_t offset = allocator.Allocate(size, alignment);
+        if (offset != RangeAllocator::INVALID_OFFSET)
+            return offset;
+
+        size_t capacity = std::max(allocator.Capacity(), initialCapacity);
+        while (capacity < allocator.Capacity() + size + alignment)
+            capacity *= 2;
+        growBuffer(buffer, allocator.Capacity() * unitSize, capacity * unitSize, name);
+        allocator.Grow(capacity);
+        grew = true;
+        return allocator.Allocate(size, alignment);
+    }
+
+    // Writes `count` indices at `byteOffset` of the bound GL_COPY_WRITE_BUFFER, narrowing them if needed
+    void uploadIndices(GLenum type, size_t byteOffset, const GLuint *indices, GLsizei count)
+    {
+        if (type == GL_UNSIGNED_INT)
+        {
+            glBufferSubData(GL_COPY_WRITE_BUFFER, byteOffset, count * sizeof(GLuint), indices);
+            return;
+        }
+        std::vector<GLushort> narrowed(indices, indices + count);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, byteOffset, count * sizeof(GLushort), narrowed.data());
+    }
+}
+
+float GeometryArenaStats::VertexFragmentation() const
+{
+    const size_t freeBytes = vertexCapacity - vertexUsed;
+    return freeBytes ? 1.f - float(vertexLargestFreeBlock) / float(freeBytes) : 0.f;
+}
+
+float GeometryArenaStats::IndexFragmentation() const
+{
+    const size_t freeBytes = indexCapacity - indexUsed;
+    return freeBytes ? 1.f - float(indexLargestFreeBlock) / float(freeBytes) : 0.f;
+}
+
+GeometryAllocation GeometryArena::Allocate(VertexFormat format, const void *vertices, GLsizei vertexCount, const void *indices, GLsizei indexCount)
+{
+    GeometryAllocation allocation;
+    if (vertexCount <= 0 || indexCount <= 0)
+        return allocation;
+
+    FormatBuffers& buffers = formats[format];
+    const size_t stride = VertexStride(format);
+    // indices are relative to the base vertex, so only the mesh's own vertex count matters
+    const GLenum indexType = IndexType(vertexCount);
+    const size_t indexBytes = indexCount * IndexSize(indexType);
+    bool grew = !buffers.VAO;
+    const size_t firstVertex = allocateGrowing(buffers.vertices, buffers.VBO, BUFFER_NAMES[format][0], stride, INITIAL_VERTICES, vertexCount, 1, grew);
+    const size_t indexOffset = allocateGrowing(buffers.indices, buffers.EBO, BUFFER_NAMES[format][1], 1, INITIAL_INDEX_BYTES, indexBytes, IndexSize(indexType), grew);
+    if (firstVertex == RangeAllocator::INVALID_OFFSET || indexOffset == RangeAllocator::INVALID_OFFSET)
+    {
+        std::cerr << "ERROR::GEOMETRY_ARENA::ALLOCATION_FAILED " << vertexCount << " vertices, " << indexCount << " indices" << std::endl;
+        buffers.vertices.Free(firstVertex, vertexCount);
+        buffers.indices.Free(indexOffset, indexBytes);
+        return allocation;
+    }
+    if (grew)
+        rebindVertexArray(format);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffers.VBO);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, firstVertex * stride, vertexCount * stride, vertices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffers.EBO);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset, indexBytes, indices);
+
+    allocation.format = format;
+    allocation.baseVertex = (GLint)firstVertex;
+    allocation.vertexCount = vertexCount;
+    allocation.indexOffset = indexOffset;
+    allocation.indexCount = indexCount;
+    allocation.indexType = indexType;
+    ++buffers.allocations;
+    return allocation;
+}
+
+void GeometryArena::Free(GeometryAllocation &allocation)
+{
+    if (!allocation.IsValid())
+        return;
+    // bookkeeping only, safe after the context is gone
+    FormatBuffers& buffers = formats[allocation.format];
+    buffers.vertices.Free(allocation.baseVertex, allocation.vertexCount);
+    buffers.indices.Free(allocation.indexOffset, allocation.indexCount * IndexSize(allocation.indexType));
+    --buffers.allocations;
+    allocation = GeometryAllocation{};
+}
+
+void GeometryArena::UpdateIndices(const GeometryAllocation &allocation, GLsizei first, GLsizei count, const GLuint *indices)
+{
+    if (!allocation.IsValid() || count <= 0)
+        return;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, formats[allocation.format].EBO);
+    uploadIndices(allocation.indexType, allocation.indexOffset + first * IndexSize(allocation.indexType), indices, count);
+}
+
+void GeometryArena::ReplaceIndices(GeometryAllocation &allocation, const GLuint *indices, GLsizei indexCount)
+{
+    if (!allocation.IsValid())
+        return;
+    if (indexCount == allocation.indexCount)
+    {
+        UpdateIndices(allocation, 0, indexCount, indices);
+        return;
+    }
+
+    FormatBuffers& buffers = formats[allocation.format];
+    buffers.indices.Free(allocation.indexOffset, allocation.indexCount * IndexSize(allocation.indexType));
+    allocation.indexCount = 0;
+    if (indexCount <= 0)
+        return;
+    bool grew = false;
+    const size_t indexOffset = allocateGrowing(buffers.indices, buffers.EBO, BUFFER_NAMES[allocation.format][1], 1, INITIAL_INDEX_BYTES, indexCount * IndexSize(allocation.indexType), IndexSize(allocation.indexType), grew);
+    if (indexOffset == RangeAllocator::INVALID_OFFSET)
+    {
+        std::cerr << "ERROR::GEOMETRY_ARENA::ALLOCATION_FAILED " << indexCount << " indices" << std::endl;
+        return;
+    }
+    if (grew)
+        rebindVertexArray(allocation.format);
+    allocation.indexOffset = indexOffset;
+    allocation.indexCount = indexCount;
+    UpdateIndices(allocation, 0, indexCount, indices);
+}
+
+void GeometryArena::Draw(const GeometryAllocation &allocation)
+{
+    Draw(allocation, 0, allocation.indexCount);
+}
+
+void GeometryArena::Draw(const GeometryAllocation &allocation, GLsizei firstIndex, GLsizei indexCount)
+{
+    if (!allocation.IsValid() || indexCount <= 0)
+        return;
+    GLState::BindVertexArray(formats[allocation.format].VAO);
+    const size_t offset = allocation.indexOffset + firstIndex * IndexSize(allocation.indexType);
+    glDrawElementsBaseVertex(GL_TRIANGLES, indexCount, allocation.indexType, (void*)offset, allocation.baseVertex);
+}
+
+void GeometryArena::UploadInstances(const InstanceData *instances, GLsizei count)
+{
+    if (count <= 0 || !instanceVBO)
+        return;
+    // orphaned every time, the VAOs read from offset 0 and the previous draw may still be in flight
+    glBindBuffer(GL_COPY_WRITE_BUFFER, instanceVBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, count * sizeof(InstanceData), instances, GL_STREAM_DRAW);
+    if (count * sizeof(InstanceData) != instanceBytes)
+    {
+        instanceBytes = count * sizeof(InstanceData);
+        MemoryTracker::Track(MEMORY_GEOMETRY, MEMORY_OBJECT_BUFFER, instanceVBO, "instance data", instanceBytes);
+    }
+}
+
+void GeometryArena::DrawInstanced(const GeometryAllocation &allocation, GLsizei firstIndex, GLsizei indexCount, GLsizei instanceCount)
+{
+    if (!allocation.IsValid() || indexCount <= 0 || instanceCount <= 0)
+        return;
+    GLState::BindVertexArray(formats[allocation.format].VAO);
+    const size_t offset = allocation.indexOffset + firstIndex * IndexSize(allocation.indexType);
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, indexCount, allocation.indexType, (void*)offset, instanceCount, allocation.baseVertex);
+}
+
+GLsizei GeometryArena::VertexStride(VertexFormat format)
+{
+    switch (format)
+    {
+    case VERTEX_FORMAT_PACKED:
+        return sizeof(PackedVertex);
+    case VERTEX_FORMAT_DEFAULT:
+    default:
+        return sizeof(Vertex);
+    }
+}
+
+GeometryArenaStats GeometryArena::Stats(VertexFormat format)
+{
+    const FormatBuffers& buffers = formats[format];
+    const size_t stride = VertexStride(format);
+    GeometryArenaStats stats;
+    stats.vertexCapacity = buffers.vertices.Capacity() * stride;
+    stats.vertexUsed = buffers.vertices.Used() * stride;
+    stats.vertexFreeBlocks = buffers.vertices.FreeBlocksCount();
+    stats.vertexLargestFreeBlock = buffers.vertices.LargestFreeBlock() * stride;
+    stats.indexCapacity = buffers.indices.Capacity();
+    stats.indexUsed = buffers.indices.Used();
+    stats.indexFreeBlocks = buffers.indices.FreeBlocksCount();
+    stats.indexLargestFreeBlock = buffers.indices.LargestFreeBlock();
+    stats.allocations = buffers.allocations;
+    return stats;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+
+#include "RangeAllocator.h"
+
+// Vertex layouts with their own buffers and VAO in the arena
+enum VertexFormat
+{
+    VERTEX_FORMAT_DEFAULT, // struct Vertex
+    VERTEX_FORMAT_PACKED,  // struct PackedVertex
+    VERTEX_FORMATS_COUNT
+};
+
+// Where a mesh lives in the arena. Meshes own theirs and give it back on destruction.
+// Indices are stored as GL_UNSIGNED_SHORT whenever the vertex count allows it.
+struct GeometryAllocation
+{
+    VertexFormat format = VERTEX_FORMAT_DEFAULT;
+    GLint baseVertex = -1;
+    GLsizei vertexCount = 0;
+    size_t indexOffset = 0; // bytes
+    GLsizei indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    bool IsValid() const { return baseVertex != -1; }
+};
+
+// Per-instance attributes at locations 3 to 8 of every format's VAO, see shaders/mesh_vertex.glsl
+struct InstanceData
+{
+    glm::mat4 model;
+    glm::vec4 color;
+    glm::vec4 material; // solid color, opaque, shininess, unused
+};
+
+struct GeometryArenaStats
+{
+    size_t vertexCapacity = 0; // bytes
+    size_t vertexUsed = 0;
+    size_t vertexFreeBlocks = 0;
+    size_t vertexLargestFreeBlock = 0;
+    size_t indexCapacity = 0;
+    size_t indexUsed = 0;
+    size_t indexFreeBlocks = 0;
+    size_t indexLargestFreeBlock = 0;
+    unsigned allocations = 0;
+
+    // share of the free space that can't serve an allocation as large as all of it
+    float VertexFragmentation() const;
+    float IndexFragmentation() const;
+};
+
+// All mesh geometry is sub-allocated from one vertex and one index buffer per
+// vertex format, drawn with glDrawElementsBaseVertex from a single VAO per format.
+// Buffers grow by reallocation, allocations keep their offsets.
+class GeometryArena
+{
+public:
+    // Both arrays are copied as is, indices must already be of IndexType(vertexCount)
+    static GeometryAllocation Allocate(VertexFormat format, const void *vertices, GLsizei vertexCount, const void *indices, GLsizei indexCount);
+    static void Free(GeometryAllocation &allocation);
+
+    // Rewrites [first, first + count) of the allocation's indices
+    static void UpdateIndices(const GeometryAllocation &allocation, GLsizei first, GLsizei count, const GLuint *indices);
+    // Moves the allocation's indices to a new range if the count changed
+    static void ReplaceIndices(GeometryAllocation &allocation, const GLuint *indices, GLsizei indexCount);
+
+    static void Draw(const GeometryAllocation &allocation);
+    // Draws `indexCount` indices starting at `firstIndex` of the allocation's indices
+    static void Draw(const GeometryAllocation &allocation, GLsizei firstIndex, GLsizei indexCount);
+
+    // Replaces the instances read by DrawInstanced
+    static void UploadInstances(const InstanceData *instances, GLsizei count);
+    static void DrawInstanced(const GeometryAllocation &allocation, GLsizei firstIndex, GLsizei indexCount, GLsizei instanceCount);
+
+    static GeometryArenaStats Stats(VertexFormat format);
+
+    static GLsizei VertexStride(VertexFormat format);
+    // GL_UNSIGNED_SHORT whenever the vertex count allows it
+    static GLenum IndexType(GLsizei vertexCount) { return vertexCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT; }
+    static size_t IndexSize(GLenum indexType) { return indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint); }
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// 64-bit FNV-1a, used to key on-disk caches. Chain calls by passing the previous hash as seed.
+const uint64_t HASH64_SEED = 14695981039346656037ull;
+
+inline uint64_t Hash64(const void *data, size_t size, uint64_t hash = HASH64_SEED)
+{
+    const uint8_t *bytes = static_cast<const uint8_t*>(data);
+    for(size_t i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
+
+inline uint64_t Hash64(const std::string &str, uint64_t hash = HASH64_SEED)
+{
+    // hash the terminator too so that ("ab", "c") and ("a", "bc") differ
+    return Hash64(str.c_str(), str.size() + 1, hash);
+}
+
+inline std::string HashToString(uint64_t hash)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string str(16, '0');
+    for(int i = 15; i >= 0; --i, hash >>= 4)
+        str[i] = digits[hash & 0xF];
+    return str;
+}
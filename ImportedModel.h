@@ -0,0 +1,47 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mesh.h"
+#include "MappedFile.h"
+#include "AssetRegistry.h"
+
+// One aiMesh with its node transform applied, before it's built into an ImportedMesh
+struct ImportedMeshPart
+{
+    std::string name;
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    std::vector<Texture> textures;
+};
+
+// One mesh of an import, geometry in the arena layout but not uploaded yet
+struct ImportedMesh
+{
+    std::string name;
+    // own the geometry, empty when it points into a baked file instead
+    std::vector<char> vertexData;
+    std::vector<char> indexData;
+    MeshGeometry geometry;
+    std::vector<Texture> textures; // type and path only, the GL textures are created on upload
+    // only filled with ImportOptions::keepCpuData
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+};
+
+// Everything a model import does off the GL thread, see Model::Read and Model::UploadMesh.
+// Geometry may point into the meshes' buffers or bakedFile, so it's never copied.
+struct ImportedModel
+{
+    std::string directory;
+    std::vector<ImportedMesh> meshes;
+    std::unique_ptr<MappedFile> bakedFile;
+    std::map<std::string, std::shared_ptr<const TextureImage>> images; // by texture path as the meshes reference it
+
+    ImportedModel() = default;
+    ImportedModel(const ImportedModel&) = delete;
+    ImportedModel& operator=(const ImportedModel&) = delete;
+};
@@ -0,0 +1,82 @@
+#include "LightBuffer.h"
+#include "globalData.h"
+#include <iostream>
+#include <cstring>
+
+LightBuffer::LightBuffer()
+    : ubo(LIGHTS_BINDING, sizeof(LightsData))
+{
+}
+
+bool LightBuffer::Update(const std::vector<Light> &lights, unsigned version)
+{
+    if (version == uploadedVersion)
+        return false;
+    uploadedVersion = version;
+
+    LightsData data;
+    std::memset(&data, 0, sizeof(data));
+    bool overflow = false;
+    for(const Light &light : lights)
+    {
+        switch (light.type)
+        {
+        case 0:
+        {
+            if (data.pointLightsCount == MAX_POINT_LIGHTS)
+            {
+                overflow = true;
+                break;
+            }
+            GpuPointLight &gpuLight = data.pointLights[data.pointLightsCount++];
+            gpuLight.position = light.location;
+            gpuLight.constant = light.constant;
+            gpuLight.linear = light.linear;
+            gpuLight.quadratic = light.quadratic;
+            gpuLight.ambient = light.ambient;
+            gpuLight.diffuse = light.diffuse;
+            gpuLight.specular = light.specular;
+            break;
+        }
+        case 1:
+        {
+            if (data.dirLightsCount == MAX_DIR_LIGHTS)
+            {
+                overflow = true;
+                break;
+            }
+            GpuDirLight &gpuLight = data.dirLights[data.dirLightsCount++];
+            gpuLight.direction = light.direction;
+            gpuLight.ambient = light.ambient;
+            gpuLight.diffuse = light.diffuse;
+            gpuLight.specular = light.specular;
+            break;
+        }
+        case 2:
+        {
+            if (data.spotLightsCount == MAX_SPOT_LIGHTS)
+            {
+                overflow = true;
+                break;
+            }
+            GpuSpotLight &gpuLight = data.spotLights[data.spotLightsCount++];
+            gpuLight.direction = light.direction;
+            gpuLight.position = light.location;
+            gpuLight.innerCutOff = light.innerCutOff;
+            gpuLight.outerCutOff = light.outerCutOff;
+            gpuLight.ambient = light.ambient;
+            gpuLight.diffuse = light.diffuse;
+            gpuLight.specular = light.specular;
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+    if (overflow)
+        std::cerr << "ERROR::LIGHTS::TOO_MANY_LIGHTS extra lights are ignored" << std::endl;
+
+    ubo.Upload(data);
+    return true;
+}
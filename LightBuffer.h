@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "UniformBuffer.h"
+
+struct Light;
+
+// Mirrors of the light structs in shaders/lights.glsl
+struct GpuDirLight
+{
+    glm::vec3 direction;
+    float padding0;
+    glm::vec3 ambient;
+    float padding1;
+    glm::vec3 diffuse;
+    float padding2;
+    glm::vec3 specular;
+    float padding3;
+};
+
+struct GpuPointLight
+{
+    glm::vec3 position;
+    float constant;
+    float linear;
+    float quadratic;
+    float padding0[2];
+    glm::vec3 ambient;
+    float padding1;
+    glm::vec3 diffuse;
+    float padding2;
+    glm::vec3 specular;
+    float padding3;
+};
+
+struct GpuSpotLight
+{
+    glm::vec3 direction;
+    float padding0;
+    glm::vec3 position;
+    float innerCutOff;
+    float outerCutOff;
+    float padding1[3];
+    glm::vec3 ambient;
+    float padding2;
+    glm::vec3 diffuse;
+    float padding3;
+    glm::vec3 specular;
+    float padding4;
+};
+
+const int MAX_DIR_LIGHTS = 10;
+const int MAX_POINT_LIGHTS = 10;
+const int MAX_SPOT_LIGHTS = 10;
+
+struct LightsData
+{
+    GpuDirLight dirLights[MAX_DIR_LIGHTS];
+    GpuPointLight pointLights[MAX_POINT_LIGHTS];
+    GpuSpotLight spotLights[MAX_SPOT_LIGHTS];
+    int dirLightsCount;
+    int pointLightsCount;
+    int spotLightsCount;
+    int padding;
+};
+
+CHECK_STD140_OFFSET(GpuDirLight, ambient, 16);
+CHECK_STD140_OFFSET(GpuDirLight, specular, 48);
+static_assert(sizeof(GpuDirLight) == 64, "GpuDirLight doesn't match the std140 layout");
+CHECK_STD140_OFFSET(GpuPointLight, constant, 12);
+CHECK_STD140_OFFSET(GpuPointLight, quadratic, 20);
+CHECK_STD140_OFFSET(GpuPointLight, ambient, 32);
+CHECK_STD140_OFFSET(GpuPointLight, specular, 64);
+static_assert(sizeof(GpuPointLight) == 80, "GpuPointLight doesn't match the std140 layout");
+CHECK_STD140_OFFSET(GpuSpotLight, position, 16);
+CHECK_STD140_OFFSET(GpuSpotLight, innerCutOff, 28);
+CHECK_STD140_OFFSET(GpuSpotLight, outerCutOff, 32);
+CHECK_STD140_OFFSET(GpuSpotLight, ambient, 48);
+CHECK_STD140_OFFSET(GpuSpotLight, specular, 80);
+static_assert(sizeof(GpuSpotLight) == 96, "GpuSpotLight doesn't match the std140 layout");
+CHECK_STD140_OFFSET(LightsData, pointLights, 640);
+CHECK_STD140_OFFSET(LightsData, spotLights, 1440);
+CHECK_STD140_OFFSET(LightsData, dirLightsCount, 2400);
+static_assert(sizeof(LightsData) % 16 == 0, "LightsData doesn't match the std140 layout");
+
+// Packs GlobalData::lights into the Lights block. Nothing is uploaded until the lights version changes.
+class LightBuffer
+{
+    UniformBuffer ubo;
+    unsigned uploadedVersion = ~0u;
+
+public:
+    LightBuffer();
+
+    bool Update(const std::vector<Light> &lights, unsigned version);
+};
@@ -0,0 +1,164 @@
+#include "MappedIOSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <map>
+#include <mutex>
+
+size_t MappedIOSystem::cacheBytes = 64 << 20;
+
+namespace
+{
+    // open, fstat, mmap and close, see MappedFile::Open
+    const size_t SYSCALLS_PER_MAPPING = 4;
+
+    struct CachedFile
+    {
+        std::shared_ptr<const MappedFile> file;
+        std::list<std::string>::iterator age;
+    };
+
+    std::mutex cacheMutex;
+    std::map<std::string, CachedFile> cache;
+    std::list<std::string> ages; // least recently used first
+    size_t cachedBytes = 0;
+
+    // empty files can't be mapped, but they exist for Assimp
+    bool isEmptyFile(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        return file.is_open() && file.tellg() == std::streampos(0);
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    class MappedIOStream : public Assimp::IOStream
+    {
+    public:
+        MappedIOStream(std::shared_ptr<const MappedFile> file_, AssimpIOStats &stats_)
+            : file(std::move(file_))
+            , stats(stats_)
+        {
+        }
+
+        size_t Read(void *buffer, size_t size, size_t count) override
+        {
+            if (size == 0 || file->Size() == 0)
+                return 0;
+            const auto start = std::chrono::steady_clock::now();
+            count = std::min(count, (file->Size() - position) / size);
+            std::memcpy(buffer, file->Data() + position, size * count);
+            position += size * count;
+            ++stats.readCalls;
+            stats.bytesRead += size * count;
+            stats.readSeconds += secondsSince(start);
+            return count;
+        }
+
+        size_t Write(const void*, size_t, size_t) override
+        {
+            return 0;
+        }
+
+        // like Assimp's MemoryIOStream, the offset from the end is positive
+        aiReturn Seek(size_t offset, aiOrigin origin) override
+        {
+            size_t target;
+            if (origin == aiOrigin_SET)
+                target = offset;
+            else if (origin == aiOrigin_CUR)
+                target = position + offset;
+            else if (origin == aiOrigin_END && offset <= file->Size())
+                target = file->Size() - offset;
+            else
+                return aiReturn_FAILURE;
+            if (target > file->Size())
+                return aiReturn_FAILURE;
+            position = target;
+            return aiReturn_SUCCESS;
+        }
+
+        size_t Tell() const override { return position; }
+        size_t FileSize() const override { return file->Size(); }
+        void Flush() override {}
+
+    private:
+        std::shared_ptr<const MappedFile> file;
+        size_t position = 0;
+        AssimpIOStats &stats;
+    };
+}
+
+std::shared_ptr<const MappedFile> MappedIOSystem::Map(const std::string &path, AssimpIOStats *stats/* = nullptr*/)
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto cached = cache.find(path);
+    if (cached != cache.end())
+    {
+        ages.splice(ages.end(), ages, cached->second.age);
+        if (stats)
+            ++stats->cacheHits;
+        return cached->second.file;
+    }
+
+    auto file = std::make_shared<MappedFile>();
+    const bool mapped = file->Open(path);
+    // an empty file is served as an unmapped MappedFile of size 0
+    const bool empty = !mapped && isEmptyFile(path);
+    if (stats)
+    {
+        stats->syscalls += SYSCALLS_PER_MAPPING;
+        stats->filesMapped += mapped;
+        stats->readSeconds += secondsSince(start);
+    }
+    if (!mapped && !empty)
+        return nullptr;
+
+    cache[path] = CachedFile{file, ages.insert(ages.end(), path)};
+    cachedBytes += file->Size();
+    // files still streamed from stay mapped through their own references
+    while (cachedBytes > cacheBytes && ages.size() > 1)
+    {
+        auto oldest = cache.find(ages.front());
+        cachedBytes -= oldest->second.file->Size();
+        cache.erase(oldest);
+        ages.pop_front();
+    }
+    return file;
+}
+
+void MappedIOSystem::ClearCache()
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache.clear();
+    ages.clear();
+    cachedBytes = 0;
+}
+
+bool MappedIOSystem::Exists(const char *file) const
+{
+    // the importer opens what it asked about right after, so it's mapped here already
+    return Map(file, &stats) != nullptr;
+}
+
+Assimp::IOStream *MappedIOSystem::Open(const char *file, const char *mode/* = "rb"*/)
+{
+    if (std::strchr(mode, 'w') || std::strchr(mode, 'a'))
+        return nullptr;
+    std::shared_ptr<const MappedFile> mapped = Map(file, &stats);
+    if (!mapped)
+        return nullptr;
+    ++stats.filesOpened;
+    return new MappedIOStream(std::move(mapped), stats);
+}
+
+void MappedIOSystem::Close(Assimp::IOStream *stream)
+{
+    delete stream;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "MappedFile.h"
+
+// What one import asked of the file system. Reads come out of mappings, so
+// the only syscalls are the ones mapping a file that wasn't cached yet.
+struct AssimpIOStats
+{
+    size_t filesOpened = 0;
+    size_t cacheHits = 0;
+    size_t filesMapped = 0;
+    size_t syscalls = 0;
+    size_t readCalls = 0;
+    size_t bytesRead = 0;
+    double readSeconds = 0.0; // mapping plus copying out of the mappings
+};
+
+// Assimp::IOSystem serving read-only files from memory mappings. The mappings are shared
+// by every import through a cache, .mtl files and textures referenced by many models
+// are only mapped once. Set one per Importer, it's used on the importing thread only.
+class MappedIOSystem : public Assimp::IOSystem
+{
+public:
+    // mappings kept after their last stream closed, oldest evicted first
+    static size_t cacheBytes;
+
+    bool Exists(const char *file) const override;
+    char getOsSeparator() const override { return '/'; }
+    // read modes only
+    Assimp::IOStream *Open(const char *file, const char *mode = "rb") override;
+    void Close(Assimp::IOStream *stream) override;
+
+    const AssimpIOStats &Stats() const { return stats; }
+
+    // Thread-safe, null if the file can't be mapped. Empty files give an unmapped file of size 0.
+    static std::shared_ptr<const MappedFile> Map(const std::string &path, AssimpIOStats *stats = nullptr);
+    static void ClearCache();
+
+private:
+    mutable AssimpIOStats stats;
+};
@@ -0,0 +1,126 @@
+#include "MemoryTracker.h"
+#include "json.hpp"
+#include <algorithm>
+
+std::map<uint64_t, MemoryEntry> MemoryTracker::entries[MEMORY_CATEGORIES_COUNT];
+size_t MemoryTracker::totals[MEMORY_CATEGORIES_COUNT] = {};
+
+namespace
+{
+    uint64_t objectKey(MemoryObjectType type, GLuint object)
+    {
+        return (uint64_t(type) << 32) | object;
+    }
+}
+
+void MemoryTracker::Track(MemoryCategory category, MemoryObjectType type, GLuint object, const std::string &name, size_t bytes)
+{
+    track(category, objectKey(type, object), name, bytes);
+}
+
+void MemoryTracker::Untrack(MemoryCategory category, MemoryObjectType type, GLuint object)
+{
+    untrack(category, objectKey(type, object));
+}
+
+void MemoryTracker::Track(MemoryCategory category, const void *owner, const std::string &name, size_t bytes)
+{
+    track(category, (uint64_t)(uintptr_t)owner, name, bytes);
+}
+
+void MemoryTracker::Untrack(MemoryCategory category, const void *owner)
+{
+    untrack(category, (uint64_t)(uintptr_t)owner);
+}
+
+void MemoryTracker::track(MemoryCategory category, uint64_t key, const std::string &name, size_t bytes)
+{
+    MemoryEntry &entry = entries[category][key];
+    totals[category] += bytes - entry.bytes;
+    entry.name = name;
+    entry.bytes = bytes;
+}
+
+void MemoryTracker::untrack(MemoryCategory category, uint64_t key)
+{
+    auto entry = entries[category].find(key);
+    if (entry == entries[category].end())
+        return;
+    totals[category] -= entry->second.bytes;
+    entries[category].erase(entry);
+}
+
+size_t MemoryTracker::Bytes(MemoryCategory category)
+{
+    return totals[category];
+}
+
+size_t MemoryTracker::HostBytes()
+{
+    size_t bytes = 0;
+    for(int category = 0; category < MEMORY_CATEGORIES_COUNT; ++category)
+        if (IsHostMemory((MemoryCategory)category))
+            bytes += totals[category];
+    return bytes;
+}
+
+size_t MemoryTracker::GPUBytes()
+{
+    size_t bytes = 0;
+    for(int category = 0; category < MEMORY_CATEGORIES_COUNT; ++category)
+        if (!IsHostMemory((MemoryCategory)category))
+            bytes += totals[category];
+    return bytes;
+}
+
+const std::map<uint64_t, MemoryEntry> &MemoryTracker::Entries(MemoryCategory category)
+{
+    return entries[category];
+}
+
+const char *MemoryTracker::CategoryName(MemoryCategory category)
+{
+    switch (category)
+    {
+    case MEMORY_GEOMETRY:        return "Geometry";
+    case MEMORY_TEXTURES:        return "Textures";
+    case MEMORY_CUBEMAPS:        return "Cubemaps";
+    case MEMORY_FRAMEBUFFERS:    return "Framebuffers";
+    case MEMORY_UNIFORM_BUFFERS: return "Uniform buffers";
+    case MEMORY_MESH_CPU_DATA:   return "Mesh CPU data";
+    default:                     return "Unknown";
+    }
+}
+
+size_t MemoryTracker::ImageBytes(GLsizei width, GLsizei height, size_t bytesPerPixel, int levels/* = 1*/)
+{
+    size_t bytes = 0;
+    for(int level = 0; levels == 0 || level < levels; ++level)
+    {
+        bytes += size_t(width) * size_t(height) * bytesPerPixel;
+        if (width == 1 && height == 1)
+            break;
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+    return bytes;
+}
+
+void MemoryTracker::Dump(std::ostream &out)
+{
+    nlohmann::json jDump;
+    jDump["hostBytes"] = HostBytes();
+    jDump["gpuBytes"] = GPUBytes();
+    for(int category = 0; category < MEMORY_CATEGORIES_COUNT; ++category)
+    {
+        nlohmann::json jCategory;
+        jCategory["name"] = CategoryName((MemoryCategory)category);
+        jCategory["host"] = IsHostMemory((MemoryCategory)category);
+        jCategory["bytes"] = totals[category];
+        jCategory["entries"] = nlohmann::json::array();
+        for(const auto &entry : entries[category])
+            jCategory["entries"].push_back({{"name", entry.second.name}, {"bytes", entry.second.bytes}});
+        jDump["categories"].push_back(jCategory);
+    }
+    out << jDump.dump(4) << std::endl;
+}
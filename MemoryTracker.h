@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+
+enum MemoryCategory
+{
+    MEMORY_GEOMETRY,        // vertex, index and instance buffers
+    MEMORY_TEXTURES,
+    MEMORY_CUBEMAPS,
+    MEMORY_FRAMEBUFFERS,    // attachments and the screen quad
+    MEMORY_UNIFORM_BUFFERS,
+    MEMORY_MESH_CPU_DATA,   // vertices and indices meshes keep in host memory
+    MEMORY_CATEGORIES_COUNT
+};
+
+// GL object names are only unique per object type
+enum MemoryObjectType
+{
+    MEMORY_OBJECT_BUFFER,
+    MEMORY_OBJECT_TEXTURE,
+    MEMORY_OBJECT_RENDERBUFFER
+};
+
+struct MemoryEntry
+{
+    std::string name;
+    size_t bytes = 0;
+};
+
+// Sizes of GL objects and host copies as they are created and deleted. GPU sizes are
+// estimates from the internal formats, drivers may pad or compress differently.
+class MemoryTracker
+{
+public:
+    // Tracking an object again replaces its entry, e.g. after a buffer is respecified
+    static void Track(MemoryCategory category, MemoryObjectType type, GLuint object, const std::string &name, size_t bytes);
+    static void Untrack(MemoryCategory category, MemoryObjectType type, GLuint object);
+    static void Track(MemoryCategory category, const void *owner, const std::string &name, size_t bytes);
+    static void Untrack(MemoryCategory category, const void *owner);
+
+    static size_t Bytes(MemoryCategory category);
+    static size_t HostBytes();
+    static size_t GPUBytes();
+    static const std::map<uint64_t, MemoryEntry> &Entries(MemoryCategory category);
+    static const char *CategoryName(MemoryCategory category);
+    static bool IsHostMemory(MemoryCategory category) { return category == MEMORY_MESH_CPU_DATA; }
+
+    // Bytes of a 2D image with `levels` mipmap levels, 0 for the full chain
+    static size_t ImageBytes(GLsizei width, GLsizei height, size_t bytesPerPixel, int levels = 1);
+
+    // Per-category totals and entries as JSON
+    static void Dump(std::ostream &out);
+
+private:
+    static std::map<uint64_t, MemoryEntry> entries[MEMORY_CATEGORIES_COUNT];
+    static size_t totals[MEMORY_CATEGORIES_COUNT];
+
+    static void track(MemoryCategory category, uint64_t key, const std::string &name, size_t bytes);
+    static void untrack(MemoryCategory category, uint64_t key);
+};
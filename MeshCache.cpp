@@ -0,0 +1,312 @@
+#include "MeshCache.h"
+#include "FileUtils.h"
+#include "Hash.h"
+#include "MappedFile.h"
+#include <cstring>
+#include <iostream>
+
+std::string MeshCache::cacheDirectory = "mesh_cache";
+
+namespace
+{
+    const char MESH_CACHE_MAGIC[4] = {'M', 'E', 'S', 'H'};
+    const uint32_t MESH_CACHE_VERSION = 2;
+    const size_t BLOB_ALIGNMENT = 16;
+
+    // File layout: header, mesh records, texture records, LODs, sub-meshes, strings, then the 16-byte aligned blobs.
+    // Offsets are from the start of the file, strings are offsets into the string table.
+    struct FileHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t sourceHash;
+        uint32_t meshCount;
+        uint32_t textureCount;
+        uint32_t lodCount;
+        uint32_t subMeshCount;
+        uint32_t stringsSize;
+        uint32_t padding;
+    };
+
+    struct MeshRecord
+    {
+        uint32_t format;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t firstLod;
+        uint32_t lodCount;
+        uint32_t firstTexture;
+        uint32_t textureCount;
+        uint32_t firstSubMesh;
+        uint32_t subMeshCount;
+        uint32_t name;
+        uint32_t padding;
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+        float positionScale[3];
+        float positionOffset[3];
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    struct TextureRecord
+    {
+        uint32_t type;
+        uint32_t path;
+    };
+
+    struct LodRecord
+    {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        float error;
+    };
+
+    struct SubMeshRecord
+    {
+        uint32_t name;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    template<typename T>
+    void append(std::vector<char> &file, const T &value)
+    {
+        file.insert(file.end(), (const char*)&value, (const char*)(&value + 1));
+    }
+
+    template<typename T>
+    T read(const unsigned char *data)
+    {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    uint32_t addString(std::vector<char> &strings, const std::string &str)
+    {
+        const uint32_t offset = (uint32_t)strings.size();
+        strings.insert(strings.end(), str.c_str(), str.c_str() + str.size() + 1);
+        return offset;
+    }
+
+    void storeVec3(float *out, const glm::vec3 &value)
+    {
+        out[0] = value.x;
+        out[1] = value.y;
+        out[2] = value.z;
+    }
+
+    glm::vec3 loadVec3(const float *in)
+    {
+        return glm::vec3{in[0], in[1], in[2]};
+    }
+}
+
+std::string MeshCache::CachePath(const std::string &sourcePath, const ImportOptions &options)
+{
+    uint64_t key = Hash64(sourcePath);
+    const bool flags[] = {options.optimize, options.generateLods, options.batchStatic};
+    key = Hash64(flags, sizeof(flags), key);
+    return cacheDirectory + "/" + HashToString(key) + ".mesh";
+}
+
+uint64_t MeshCache::SourceHash(const std::string &sourcePath)
+{
+    MappedFile source;
+    if (!source.Open(sourcePath))
+        return 0;
+    return Hash64(source.Data(), source.Size());
+}
+
+bool MeshCache::Read(const std::string &cachePath, uint64_t sourceHash, ImportedModel &imported)
+{
+    auto file = std::make_unique<MappedFile>();
+    if (!file->Open(cachePath) || file->Size() < sizeof(FileHeader))
+        return false;
+    const unsigned char *data = file->Data();
+    const size_t size = file->Size();
+
+    const FileHeader header = read<FileHeader>(data);
+    if (std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != MESH_CACHE_VERSION || header.sourceHash != sourceHash)
+        return false;
+
+    const size_t meshesOffset = sizeof(FileHeader);
+    const size_t texturesOffset = meshesOffset + header.meshCount * sizeof(MeshRecord);
+    const size_t lodsOffset = texturesOffset + header.textureCount * sizeof(TextureRecord);
+    const size_t subMeshesOffset = lodsOffset + header.lodCount * sizeof(LodRecord);
+    const size_t stringsOffset = subMeshesOffset + header.subMeshCount * sizeof(SubMeshRecord);
+    if (stringsOffset + header.stringsSize > size || header.stringsSize == 0 || data[stringsOffset + header.stringsSize - 1] != '\0')
+        return false;
+    const char *strings = (const char*)data + stringsOffset;
+
+    // everything is checked first, a bad file must not leave half a model behind
+    std::vector<MeshRecord> records;
+    for(uint32_t i = 0; i < header.meshCount; ++i)
+    {
+        const MeshRecord record = read<MeshRecord>(data + meshesOffset + i * sizeof(MeshRecord));
+        if (record.format >= VERTEX_FORMATS_COUNT || record.name >= header.stringsSize
+            || (uint64_t)record.firstLod + record.lodCount > header.lodCount || record.lodCount == 0
+            || (uint64_t)record.firstTexture + record.textureCount > header.textureCount
+            || (uint64_t)record.firstSubMesh + record.subMeshCount > header.subMeshCount)
+            return false;
+        const uint64_t vertexBytes = (uint64_t)record.vertexCount * GeometryArena::VertexStride((VertexFormat)record.format);
+        const uint64_t indexBytes = (uint64_t)record.indexCount * GeometryArena::IndexSize(GeometryArena::IndexType((GLsizei)record.vertexCount));
+        if (record.vertexOffset > size || vertexBytes > size - record.vertexOffset || record.indexOffset > size || indexBytes > size - record.indexOffset)
+            return false;
+        for(uint32_t lod = record.firstLod; lod < record.firstLod + record.lodCount; ++lod)
+        {
+            const LodRecord lodRecord = read<LodRecord>(data + lodsOffset + lod * sizeof(LodRecord));
+            if ((uint64_t)lodRecord.firstIndex + lodRecord.indexCount > record.indexCount)
+                return false;
+        }
+        for(uint32_t subMesh = record.firstSubMesh; subMesh < record.firstSubMesh + record.subMeshCount; ++subMesh)
+        {
+            const SubMeshRecord subMeshRecord = read<SubMeshRecord>(data + subMeshesOffset + subMesh * sizeof(SubMeshRecord));
+            if (subMeshRecord.name >= header.stringsSize || (uint64_t)subMeshRecord.firstIndex + subMeshRecord.indexCount > record.indexCount)
+                return false;
+        }
+        records.push_back(record);
+    }
+    for(uint32_t i = 0; i < header.textureCount; ++i)
+    {
+        const TextureRecord texture = read<TextureRecord>(data + texturesOffset + i * sizeof(TextureRecord));
+        if (texture.type >= header.stringsSize || texture.path >= header.stringsSize)
+            return false;
+    }
+
+    for(const MeshRecord &record : records)
+    {
+        ImportedMesh mesh;
+        mesh.name = strings + record.name;
+        MeshGeometry &geometry = mesh.geometry;
+        geometry.format = (VertexFormat)record.format;
+        geometry.vertices = data + record.vertexOffset;
+        geometry.vertexCount = (GLsizei)record.vertexCount;
+        geometry.indices = data + record.indexOffset;
+        geometry.indexCount = (GLsizei)record.indexCount;
+        geometry.positionScale = loadVec3(record.positionScale);
+        geometry.positionOffset = loadVec3(record.positionOffset);
+        geometry.boundsMin = loadVec3(record.boundsMin);
+        geometry.boundsMax = loadVec3(record.boundsMax);
+        for(uint32_t lod = record.firstLod; lod < record.firstLod + record.lodCount; ++lod)
+        {
+            const LodRecord lodRecord = read<LodRecord>(data + lodsOffset + lod * sizeof(LodRecord));
+            geometry.lods.push_back(MeshLod{(GLsizei)lodRecord.firstIndex, (GLsizei)lodRecord.indexCount, lodRecord.error});
+        }
+        for(uint32_t i = record.firstSubMesh; i < record.firstSubMesh + record.subMeshCount; ++i)
+        {
+            const SubMeshRecord subMeshRecord = read<SubMeshRecord>(data + subMeshesOffset + i * sizeof(SubMeshRecord));
+            geometry.subMeshes.push_back(SubMesh{strings + subMeshRecord.name, (GLsizei)subMeshRecord.firstIndex, (GLsizei)subMeshRecord.indexCount,
+                                                 loadVec3(subMeshRecord.boundsMin), loadVec3(subMeshRecord.boundsMax)});
+        }
+
+        for(uint32_t i = record.firstTexture; i < record.firstTexture + record.textureCount; ++i)
+        {
+            const TextureRecord textureRecord = read<TextureRecord>(data + texturesOffset + i * sizeof(TextureRecord));
+            Texture texture;
+            texture.id = 0;
+            texture.type = strings + textureRecord.type;
+            texture.path = strings + textureRecord.path;
+            mesh.textures.push_back(texture);
+        }
+        imported.meshes.push_back(std::move(mesh));
+    }
+    imported.bakedFile = std::move(file);
+    return true;
+}
+
+bool MeshCache::Save(const std::string &cachePath, uint64_t sourceHash, const std::vector<ImportedMesh> &meshes)
+{
+    std::vector<MeshRecord> records;
+    std::vector<TextureRecord> textures;
+    std::vector<LodRecord> lods;
+    std::vector<SubMeshRecord> subMeshes;
+    std::vector<char> strings;
+    for(const ImportedMesh &mesh : meshes)
+    {
+        MeshRecord record = {};
+        record.format = (uint32_t)mesh.geometry.format;
+        record.vertexCount = (uint32_t)mesh.geometry.vertexCount;
+        record.indexCount = (uint32_t)mesh.geometry.indexCount;
+        record.firstLod = (uint32_t)lods.size();
+        record.lodCount = (uint32_t)mesh.geometry.lods.size();
+        record.firstTexture = (uint32_t)textures.size();
+        record.textureCount = (uint32_t)mesh.textures.size();
+        record.firstSubMesh = (uint32_t)subMeshes.size();
+        record.subMeshCount = (uint32_t)mesh.geometry.subMeshes.size();
+        record.name = addString(strings, mesh.name);
+        storeVec3(record.positionScale, mesh.geometry.positionScale);
+        storeVec3(record.positionOffset, mesh.geometry.positionOffset);
+        storeVec3(record.boundsMin, mesh.geometry.boundsMin);
+        storeVec3(record.boundsMax, mesh.geometry.boundsMax);
+        for(const MeshLod &lod : mesh.geometry.lods)
+            lods.push_back(LodRecord{(uint32_t)lod.firstIndex, (uint32_t)lod.indexCount, lod.error});
+        for(const Texture &texture : mesh.textures)
+            textures.push_back(TextureRecord{addString(strings, texture.type), addString(strings, texture.path)});
+        for(const SubMesh &subMesh : mesh.geometry.subMeshes)
+        {
+            SubMeshRecord subMeshRecord = {};
+            subMeshRecord.name = addString(strings, subMesh.name);
+            subMeshRecord.firstIndex = (uint32_t)subMesh.firstIndex;
+            subMeshRecord.indexCount = (uint32_t)subMesh.indexCount;
+            storeVec3(subMeshRecord.boundsMin, subMesh.boundsMin);
+            storeVec3(subMeshRecord.boundsMax, subMesh.boundsMax);
+            subMeshes.push_back(subMeshRecord);
+        }
+        records.push_back(record);
+    }
+    if (strings.empty())
+        strings.push_back('\0');
+
+    size_t blobsOffset = sizeof(FileHeader) + records.size() * sizeof(MeshRecord) + textures.size() * sizeof(TextureRecord)
+                       + lods.size() * sizeof(LodRecord) + subMeshes.size() * sizeof(SubMeshRecord) + strings.size();
+    for(size_t i = 0; i < meshes.size(); ++i)
+    {
+        blobsOffset = (blobsOffset + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT;
+        records[i].vertexOffset = blobsOffset;
+        blobsOffset += meshes[i].vertexData.size();
+        blobsOffset = (blobsOffset + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT;
+        records[i].indexOffset = blobsOffset;
+        blobsOffset += meshes[i].indexData.size();
+    }
+
+    FileHeader header = {};
+    std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = MESH_CACHE_VERSION;
+    header.sourceHash = sourceHash;
+    header.meshCount = (uint32_t)records.size();
+    header.textureCount = (uint32_t)textures.size();
+    header.lodCount = (uint32_t)lods.size();
+    header.subMeshCount = (uint32_t)subMeshes.size();
+    header.stringsSize = (uint32_t)strings.size();
+
+    std::vector<char> file;
+    file.reserve(blobsOffset);
+    append(file, header);
+    for(const MeshRecord &record : records)
+        append(file, record);
+    for(const TextureRecord &texture : textures)
+        append(file, texture);
+    for(const LodRecord &lod : lods)
+        append(file, lod);
+    for(const SubMeshRecord &subMesh : subMeshes)
+        append(file, subMesh);
+    file.insert(file.end(), strings.begin(), strings.end());
+    for(size_t i = 0; i < meshes.size(); ++i)
+    {
+        file.resize(records[i].vertexOffset, 0);
+        file.insert(file.end(), meshes[i].vertexData.begin(), meshes[i].vertexData.end());
+        file.resize(records[i].indexOffset, 0);
+        file.insert(file.end(), meshes[i].indexData.begin(), meshes[i].indexData.end());
+    }
+
+    if (!EnsureDirectory(cacheDirectory) || !WriteFile(cachePath, file.data(), file.size()))
+    {
+        std::cerr << "ERROR::MESH_CACHE::WRITE_FAILED " << cachePath << std::endl;
+        return false;
+    }
+    return true;
+}
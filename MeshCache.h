@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ImportedModel.h"
+#include "MeshOptimizer.h"
+
+// Imported models baked to .mesh files: vertex and index blobs in the geometry arena
+// layout, LODs, bounds and material textures. A file is used only while the hash of its
+// source matches, reading maps it and the meshes are uploaded straight from the mapping.
+class MeshCache
+{
+public:
+    static std::string cacheDirectory; // empty disables the cache
+
+    // Different import options bake to different files
+    static std::string CachePath(const std::string &sourcePath, const ImportOptions &options);
+    // 0 if the source can't be read
+    static uint64_t SourceHash(const std::string &sourcePath);
+
+    // Fills the meshes of `imported` with geometry pointing into its bakedFile, leaves it untouched on failure
+    static bool Read(const std::string &cachePath, uint64_t sourceHash, ImportedModel &imported);
+    static bool Save(const std::string &cachePath, uint64_t sourceHash, const std::vector<ImportedMesh> &meshes);
+};
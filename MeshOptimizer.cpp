@@ -0,0 +1,648 @@
+#include "MeshOptimizer.h"
+#include "Hash.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+namespace
+{
+    // what the analysis assumes the hardware has, Forsyth tunes for a larger LRU
+    const size_t FIFO_CACHE_SIZE = 16;
+    const int FORSYTH_CACHE_SIZE = 32;
+    const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+    const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+    const float FORSYTH_VALENCE_BOOST_SCALE = 2.f;
+    const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+    const int OVERDRAW_RESOLUTION = 256;
+
+    struct VertexHasher
+    {
+        size_t operator()(const Vertex& vertex) const { return (size_t)Hash64(&vertex, sizeof(Vertex)); }
+    };
+
+    struct VertexEqual
+    {
+        bool operator()(const Vertex& a, const Vertex& b) const { return std::memcmp(&a, &b, sizeof(Vertex)) == 0; }
+    };
+
+    float forsythScore(int cachePosition, unsigned remainingTriangles)
+    {
+        if (remainingTriangles == 0)
+            return -1.f;
+
+        float score = 0.f;
+        if (cachePosition >= 0)
+        {
+            // the last triangle's vertices get a fixed score so that strips don't just go back and forth
+            if (cachePosition < 3)
+                score = FORSYTH_LAST_TRIANGLE_SCORE;
+            else
+                score = std::pow(1.f - float(cachePosition - 3) / float(FORSYTH_CACHE_SIZE - 3), FORSYTH_CACHE_DECAY_POWER);
+        }
+        // finish off vertices with few triangles left, they would cost a whole miss later
+        score += FORSYTH_VALENCE_BOOST_SCALE * std::pow(float(remainingTriangles), -FORSYTH_VALENCE_BOOST_POWER);
+        return score;
+    }
+
+    // Calls onRestart(triangle) for every triangle whose three vertices all miss the cache
+    template<typename OnRestart>
+    size_t simulateFifoCache(const std::vector<GLuint>& indices, size_t vertexCount, OnRestart onRestart)
+    {
+        // a vertex is cached while fewer than FIFO_CACHE_SIZE misses happened since it was loaded
+        std::vector<size_t> loadedAt(vertexCount, 0);
+        size_t time = FIFO_CACHE_SIZE + 1;
+        size_t misses = 0;
+        for(size_t triangle = 0; triangle < indices.size() / 3; ++triangle)
+        {
+            int triangleMisses = 0;
+            for(int corner = 0; corner < 3; ++corner)
+            {
+                const GLuint index = indices[triangle * 3 + corner];
+                if (time - loadedAt[index] > FIFO_CACHE_SIZE)
+                {
+                    loadedAt[index] = time++;
+                    ++triangleMisses;
+                }
+            }
+            if (triangleMisses == 3)
+                onRestart(triangle);
+            misses += triangleMisses;
+        }
+        return misses;
+    }
+
+    // Orthographic views along +-X, +-Y and +-Z with back faces culled and a depth test
+    void rasterizeOverdraw(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, size_t& shaded, size_t& covered)
+    {
+        if (vertices.empty())
+            return;
+
+        glm::vec3 minPos = vertices[0].Position;
+        glm::vec3 maxPos = vertices[0].Position;
+        for(const Vertex& vertex : vertices)
+        {
+            minPos = glm::min(minPos, vertex.Position);
+            maxPos = glm::max(maxPos, vertex.Position);
+        }
+        const glm::vec3 extent = glm::max(maxPos - minPos, glm::vec3(1e-6f));
+
+        std::vector<float> depth(OVERDRAW_RESOLUTION * OVERDRAW_RESOLUTION);
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            const int uAxis = (axis + 1) % 3;
+            const int vAxis = (axis + 2) % 3;
+            for(float side : {1.f, -1.f})
+            {
+                std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::max());
+                for(size_t i = 0; i + 2 < indices.size(); i += 3)
+                {
+                    glm::vec3 screen[3];
+                    for(int corner = 0; corner < 3; ++corner)
+                    {
+                        const glm::vec3 normalized = (vertices[indices[i + corner]].Position - minPos) / extent;
+                        screen[corner] = {normalized[uAxis] * OVERDRAW_RESOLUTION, normalized[vAxis] * OVERDRAW_RESOLUTION, -side * normalized[axis]};
+                    }
+                    const float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+                    if (area * side <= 0.f)
+                        continue;
+
+                    const int minX = std::max(0, (int)std::floor(std::min({screen[0].x, screen[1].x, screen[2].x})));
+                    const int maxX = std::min(OVERDRAW_RESOLUTION - 1, (int)std::ceil(std::max({screen[0].x, screen[1].x, screen[2].x})));
+                    const int minY = std::max(0, (int)std::floor(std::min({screen[0].y, screen[1].y, screen[2].y})));
+                    const int maxY = std::min(OVERDRAW_RESOLUTION - 1, (int)std::ceil(std::max({screen[0].y, screen[1].y, screen[2].y})));
+                    for(int y = minY; y <= maxY; ++y)
+                    {
+                        for(int x = minX; x <= maxX; ++x)
+                        {
+                            const float px = x + 0.5f;
+                            const float py = y + 0.5f;
+                            const float w0 = ((screen[2].x - screen[1].x) * (py - screen[1].y) - (screen[2].y - screen[1].y) * (px - screen[1].x)) / area;
+                            const float w1 = ((screen[0].x - screen[2].x) * (py - screen[2].y) - (screen[0].y - screen[2].y) * (px - screen[2].x)) / area;
+                            const float w2 = 1.f - w0 - w1;
+                            if (w0 < 0.f || w1 < 0.f || w2 < 0.f)
+                                continue;
+
+                            const float z = w0 * screen[0].z + w1 * screen[1].z + w2 * screen[2].z;
+                            float& stored = depth[y * OVERDRAW_RESOLUTION + x];
+                            if (z >= stored)
+                                continue;
+                            if (stored == std::numeric_limits<float>::max())
+                                ++covered;
+                            stored = z;
+                            ++shaded;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+MeshMetrics &MeshMetrics::operator+=(const MeshMetrics &other)
+{
+    vertices += other.vertices;
+    triangles += other.triangles;
+    cacheMisses += other.cacheMisses;
+    shadedPixels += other.shadedPixels;
+    coveredPixels += other.coveredPixels;
+    return *this;
+}
+
+MeshOptimizationReport MeshOptimizer::Optimize(std::vector<Vertex> &vertices, std::vector<GLuint> &indices)
+{
+    MeshOptimizationReport report;
+    report.before = Analyze(vertices, indices);
+
+    WeldVertices(vertices, indices);
+    OptimizeVertexCache(indices, vertices.size());
+    OptimizeOverdraw(indices, vertices);
+    OptimizeVertexFetch(vertices, indices);
+
+    report.after = Analyze(vertices, indices);
+    return report;
+}
+
+void MeshOptimizer::WeldVertices(std::vector<Vertex> &vertices, std::vector<GLuint> &indices)
+{
+    std::unordered_map<Vertex, GLuint, VertexHasher, VertexEqual> unique;
+    unique.reserve(vertices.size());
+    std::vector<GLuint> remap(vertices.size());
+    std::vector<Vertex> welded;
+    welded.reserve(vertices.size());
+    for(size_t i = 0; i < vertices.size(); ++i)
+    {
+        auto inserted = unique.emplace(vertices[i], (GLuint)welded.size());
+        if (inserted.second)
+            welded.push_back(vertices[i]);
+        remap[i] = inserted.first->second;
+    }
+
+    for(GLuint& index : indices)
+        index = remap[index];
+    vertices.swap(welded);
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<GLuint> &indices, size_t vertexCount)
+{
+    const size_t trianglesCount = indices.size() / 3;
+    if (trianglesCount == 0)
+        return;
+
+    // triangles of every vertex, the first remaining[v] entries of its range are the ones not emitted yet
+    std::vector<unsigned> remaining(vertexCount, 0);
+    for(GLuint index : indices)
+        ++remaining[index];
+    std::vector<size_t> adjacencyOffsets(vertexCount + 1, 0);
+    for(size_t v = 0; v < vertexCount; ++v)
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remaining[v];
+    std::vector<unsigned> adjacency(indices.size());
+    {
+        std::vector<size_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for(size_t i = 0; i < trianglesCount * 3; ++i)
+            adjacency[cursor[indices[i]]++] = unsigned(i / 3);
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for(size_t v = 0; v < vertexCount; ++v)
+        vertexScore[v] = forsythScore(-1, remaining[v]);
+
+    std::vector<float> triangleScore(trianglesCount);
+    std::vector<bool> emitted(trianglesCount, false);
+    size_t best = 0;
+    for(size_t t = 0; t < trianglesCount; ++t)
+    {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+        if (triangleScore[t] > triangleScore[best])
+            best = t;
+    }
+
+    std::vector<GLuint> optimized;
+    optimized.reserve(trianglesCount * 3);
+    std::vector<GLuint> cache;
+    std::vector<GLuint> nextCache;
+    size_t scanCursor = 0;
+    while (optimized.size() < trianglesCount * 3)
+    {
+        emitted[best] = true;
+        nextCache.clear();
+        for(int corner = 0; corner < 3; ++corner)
+        {
+            const GLuint v = indices[best * 3 + corner];
+            optimized.push_back(v);
+
+            unsigned* begin = &adjacency[adjacencyOffsets[v]];
+            unsigned* end = begin + remaining[v];
+            unsigned* found = std::find(begin, end, (unsigned)best);
+            if (found != end)
+            {
+                std::swap(*found, *(end - 1));
+                --remaining[v];
+            }
+            if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end())
+                nextCache.push_back(v);
+        }
+        for(GLuint v : cache)
+        {
+            if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end())
+                nextCache.push_back(v);
+        }
+
+        // rescore everything that was in the cache, evicted vertices included
+        for(size_t i = 0; i < nextCache.size(); ++i)
+        {
+            const GLuint v = nextCache[i];
+            cachePosition[v] = i < size_t(FORSYTH_CACHE_SIZE) ? int(i) : -1;
+            vertexScore[v] = forsythScore(cachePosition[v], remaining[v]);
+        }
+
+        float bestScore = -1.f;
+        for(GLuint v : nextCache)
+        {
+            for(size_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v] + remaining[v]; ++a)
+            {
+                const unsigned t = adjacency[a];
+                triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                if (triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+
+        if (nextCache.size() > size_t(FORSYTH_CACHE_SIZE))
+            nextCache.resize(FORSYTH_CACHE_SIZE);
+        cache.swap(nextCache);
+
+        // nothing left around the cache, restart from the next triangle in input order
+        if (bestScore < 0.f)
+        {
+            while (scanCursor < trianglesCount && emitted[scanCursor])
+                ++scanCursor;
+            best = scanCursor;
+        }
+    }
+
+    indices.swap(optimized);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<GLuint> &indices, const std::vector<Vertex> &vertices)
+{
+    const size_t trianglesCount = indices.size() / 3;
+    if (trianglesCount == 0)
+        return;
+
+    // clusters start where the cache restarts, so reordering them costs almost no extra misses
+    std::vector<size_t> clusterStarts;
+    simulateFifoCache(indices, vertices.size(), [&clusterStarts](size_t triangle) {
+        clusterStarts.push_back(triangle);
+    });
+    if (clusterStarts.empty() || clusterStarts[0] != 0)
+        clusterStarts.insert(clusterStarts.begin(), 0);
+    clusterStarts.push_back(trianglesCount);
+
+    glm::vec3 meshCentroid{0.f};
+    for(GLuint index : indices)
+        meshCentroid += vertices[index].Position;
+    meshCentroid /= float(indices.size());
+
+    struct Cluster
+    {
+        size_t firstTriangle;
+        size_t trianglesCount;
+        float sortKey;
+    };
+    std::vector<Cluster> clusters;
+    for(size_t c = 0; c + 1 < clusterStarts.size(); ++c)
+    {
+        Cluster cluster{clusterStarts[c], clusterStarts[c + 1] - clusterStarts[c], 0.f};
+        glm::vec3 centroid{0.f};
+        glm::vec3 normal{0.f};
+        for(size_t t = cluster.firstTriangle; t < cluster.firstTriangle + cluster.trianglesCount; ++t)
+        {
+            const glm::vec3& p0 = vertices[indices[t * 3]].Position;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].Position;
+            centroid += p0 + p1 + p2;
+            normal += glm::cross(p1 - p0, p2 - p0); // area weighted
+        }
+        centroid /= float(cluster.trianglesCount * 3);
+        const float normalLength = glm::length(normal);
+        // clusters facing away from the center tend to occlude the others
+        cluster.sortKey = normalLength > 0.f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.f;
+        clusters.push_back(cluster);
+    }
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<GLuint> sorted;
+    sorted.reserve(indices.size());
+    for(const Cluster& cluster : clusters)
+        sorted.insert(sorted.end(), indices.begin() + cluster.firstTriangle * 3, indices.begin() + (cluster.firstTriangle + cluster.trianglesCount) * 3);
+    indices.swap(sorted);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<GLuint> &indices)
+{
+    const GLuint UNUSED = ~0u;
+    std::vector<GLuint> remap(vertices.size(), UNUSED);
+    std::vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+    for(GLuint& index : indices)
+    {
+        if (remap[index] == UNUSED)
+        {
+            remap[index] = (GLuint)ordered.size();
+            ordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(ordered);
+}
+
+MeshMetrics MeshOptimizer::Analyze(const std::vector<Vertex> &vertices, const std::vector<GLuint> &indices)
+{
+    MeshMetrics metrics;
+    metrics.vertices = vertices.size();
+    metrics.triangles = indices.size() / 3;
+    metrics.cacheMisses = simulateFifoCache(indices, vertices.size(), [](size_t) {});
+    rasterizeOverdraw(vertices, indices, metrics.shadedPixels, metrics.coveredPixels);
+    return metrics;
+}
+
+namespace
+{
+    // symmetric 4x4 matrix of summed plane equations, evaluates to the sum of squared distances to them
+    struct Quadric
+    {
+        double a2 = 0, ab = 0, ac = 0, ad = 0;
+        double b2 = 0, bc = 0, bd = 0;
+        double c2 = 0, cd = 0;
+        double d2 = 0;
+
+        void AddPlane(const glm::dvec3 &n, double d)
+        {
+            a2 += n.x * n.x; ab += n.x * n.y; ac += n.x * n.z; ad += n.x * d;
+            b2 += n.y * n.y; bc += n.y * n.z; bd += n.y * d;
+            c2 += n.z * n.z; cd += n.z * d;
+            d2 += d * d;
+        }
+
+        Quadric &operator+=(const Quadric &q)
+        {
+            a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+            b2 += q.b2; bc += q.bc; bd += q.bd;
+            c2 += q.c2; cd += q.cd;
+            d2 += q.d2;
+            return *this;
+        }
+
+        double Error(const glm::vec3 &p) const
+        {
+            const double x = p.x, y = p.y, z = p.z;
+            const double error = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+                + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+                + c2 * z * z + 2 * cd * z
+                + d2;
+            return std::max(error, 0.0);
+        }
+    };
+
+    struct Collapse
+    {
+        GLuint from;
+        GLuint to;
+        double cost;
+        unsigned version; // of `from` when queued, see Simplify
+    };
+
+    // scales attribute differences into the squared distance units of the quadrics
+    const double SIMPLIFY_ATTRIBUTE_WEIGHT = 0.01;
+
+    struct PositionHasher
+    {
+        size_t operator()(const glm::vec3& p) const { return (size_t)Hash64(&p, sizeof(p)); }
+    };
+}
+
+std::vector<GLuint> MeshOptimizer::Simplify(const std::vector<Vertex> &vertices, const std::vector<GLuint> &indices, size_t targetIndexCount, float maxError, float *resultError/* = nullptr*/)
+{
+    std::vector<GLuint> result = indices;
+    if (resultError)
+        *resultError = 0.f;
+    if (vertices.empty() || result.size() <= targetIndexCount)
+        return result;
+
+    glm::vec3 minPos = vertices[0].Position;
+    glm::vec3 maxPos = vertices[0].Position;
+    for(const Vertex& vertex : vertices)
+    {
+        minPos = glm::min(minPos, vertex.Position);
+        maxPos = glm::max(maxPos, vertex.Position);
+    }
+    const double extent = glm::length(maxPos - minPos);
+    if (extent <= 0.0)
+        return result;
+    const double errorLimit = double(maxError) * extent * double(maxError) * extent;
+
+    // vertices sharing a position are attribute seams, they stay where they are
+    std::unordered_map<glm::vec3, GLuint, PositionHasher> positions;
+    std::vector<GLuint> positionGroup(vertices.size());
+    std::vector<unsigned> groupSize;
+    for(size_t v = 0; v < vertices.size(); ++v)
+    {
+        auto inserted = positions.emplace(vertices[v].Position, (GLuint)groupSize.size());
+        if (inserted.second)
+            groupSize.push_back(0);
+        positionGroup[v] = inserted.first->second;
+        ++groupSize[inserted.first->second];
+    }
+    std::vector<bool> locked(vertices.size(), false);
+    for(size_t v = 0; v < vertices.size(); ++v)
+        locked[v] = groupSize[positionGroup[v]] > 1;
+
+    // edges used by a single triangle are on an open border
+    std::unordered_map<uint64_t, unsigned> edgeUses;
+    auto edgeKey = [&positionGroup](GLuint a, GLuint b) {
+        uint64_t ga = positionGroup[a], gb = positionGroup[b];
+        return ga < gb ? (ga << 32) | gb : (gb << 32) | ga;
+    };
+    for(size_t i = 0; i + 2 < result.size(); i += 3)
+        for(int corner = 0; corner < 3; ++corner)
+            ++edgeUses[edgeKey(result[i + corner], result[i + (corner + 1) % 3])];
+    for(size_t i = 0; i + 2 < result.size(); i += 3)
+    {
+        for(int corner = 0; corner < 3; ++corner)
+        {
+            const GLuint a = result[i + corner];
+            const GLuint b = result[i + (corner + 1) % 3];
+            if (edgeUses[edgeKey(a, b)] == 1)
+                locked[a] = locked[b] = true;
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertices.size());
+    for(size_t i = 0; i + 2 < result.size(); i += 3)
+    {
+        const glm::dvec3 p0 = vertices[result[i]].Position;
+        const glm::dvec3 p1 = vertices[result[i + 1]].Position;
+        const glm::dvec3 p2 = vertices[result[i + 2]].Position;
+        glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+        const double length = glm::length(normal);
+        if (length <= 0.0)
+            continue;
+        normal /= length;
+        for(int corner = 0; corner < 3; ++corner)
+            quadrics[result[i + corner]].AddPlane(normal, -glm::dot(normal, p0));
+    }
+
+    std::vector<glm::vec3> normals(vertices.size());
+    for(size_t v = 0; v < vertices.size(); ++v)
+        normals[v] = glm::normalize(vertices[v].Normal);
+    auto collapseCost = [&](GLuint from, GLuint to) {
+        const glm::vec2 uvDelta = vertices[from].TexCoords - vertices[to].TexCoords;
+        const double normalDelta = 1.0 - glm::dot(normals[from], normals[to]);
+        const double attributeCost = SIMPLIFY_ATTRIBUTE_WEIGHT * extent * extent * (glm::dot(uvDelta, uvDelta) + normalDelta);
+        return quadrics[from].Error(vertices[to].Position) + attributeCost;
+    };
+
+    // triangles around each vertex, removed ones are dropped as collapses meet them
+    std::vector<std::vector<unsigned>> vertexTriangles(vertices.size());
+    size_t trianglesLeft = result.size() / 3;
+    std::vector<bool> removedTriangle(trianglesLeft, false);
+    for(size_t i = 0; i + 2 < result.size(); i += 3)
+        for(int corner = 0; corner < 3; ++corner)
+            vertexTriangles[result[i + corner]].push_back(unsigned(i / 3));
+
+    // each vertex has its cheapest collapse queued, entries older than its version are stale
+    std::vector<unsigned> version(vertices.size(), 0);
+    std::vector<bool> collapsedVertex(vertices.size(), false);
+    const auto costlier = [](const Collapse& a, const Collapse& b) { return a.cost > b.cost; };
+    std::priority_queue<Collapse, std::vector<Collapse>, decltype(costlier)> queue(costlier);
+    auto queueCheapest = [&](GLuint from) {
+        ++version[from];
+        if (locked[from] || collapsedVertex[from])
+            return;
+        Collapse cheapest{from, from, std::numeric_limits<double>::max(), version[from]};
+        for(unsigned triangle : vertexTriangles[from])
+        {
+            if (removedTriangle[triangle])
+                continue;
+            const GLuint *corners = &result[triangle * 3];
+            for(int corner = 0; corner < 3; ++corner)
+            {
+                if (corners[corner] == from)
+                    continue;
+                const double cost = collapseCost(from, corners[corner]);
+                if (cost < cheapest.cost)
+                {
+                    cheapest.to = corners[corner];
+                    cheapest.cost = cost;
+                }
+            }
+        }
+        if (cheapest.to != from)
+            queue.push(cheapest);
+    };
+    for(size_t v = 0; v < vertices.size(); ++v)
+        queueCheapest(GLuint(v));
+
+    double reachedError = 0.0;
+    std::vector<GLuint> neighbours;
+    while (!queue.empty() && trianglesLeft * 3 > targetIndexCount)
+    {
+        const Collapse collapse = queue.top();
+        queue.pop();
+        if (collapse.cost > errorLimit)
+            break;
+        if (collapsedVertex[collapse.from] || collapsedVertex[collapse.to] || collapse.version != version[collapse.from])
+            continue;
+
+        size_t shared = 0;
+        bool flips = false;
+        for(unsigned triangle : vertexTriangles[collapse.from])
+        {
+            if (removedTriangle[triangle])
+                continue;
+            const size_t t = triangle * 3;
+            glm::vec3 before[3], after[3];
+            bool hasTo = false;
+            for(int corner = 0; corner < 3; ++corner)
+            {
+                const GLuint v = result[t + corner];
+                hasTo = hasTo || v == collapse.to;
+                before[corner] = vertices[v].Position;
+                after[corner] = vertices[v == collapse.from ? collapse.to : v].Position;
+            }
+            if (hasTo)
+            {
+                ++shared;
+                continue;
+            }
+            const glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            const glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+            if (glm::dot(normalBefore, normalAfter) <= 0.f)
+            {
+                flips = true;
+                break;
+            }
+        }
+        // tried again once a neighbour's collapse changes its surroundings
+        if (flips || shared == 0)
+            continue;
+
+        neighbours.clear();
+        for(unsigned triangle : vertexTriangles[collapse.from])
+        {
+            if (removedTriangle[triangle])
+                continue;
+            GLuint *corners = &result[triangle * 3];
+            for(int corner = 0; corner < 3; ++corner)
+                if (corners[corner] != collapse.from && corners[corner] != collapse.to)
+                    neighbours.push_back(corners[corner]);
+            if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to)
+            {
+                removedTriangle[triangle] = true;
+                --trianglesLeft;
+                continue;
+            }
+            for(int corner = 0; corner < 3; ++corner)
+                if (corners[corner] == collapse.from)
+                    corners[corner] = collapse.to;
+            vertexTriangles[collapse.to].push_back(triangle);
+        }
+        std::vector<unsigned>().swap(vertexTriangles[collapse.from]);
+        std::vector<unsigned>& toTriangles = vertexTriangles[collapse.to];
+        toTriangles.erase(std::remove_if(toTriangles.begin(), toTriangles.end(), [&](unsigned triangle) { return removedTriangle[triangle]; }), toTriangles.end());
+        collapsedVertex[collapse.from] = true;
+        quadrics[collapse.to] += quadrics[collapse.from];
+        reachedError = std::max(reachedError, collapse.cost);
+
+        // `to` has a new quadric, the neighbours of `from` lost their edge to it and may have gained one to `to`.
+        // Edges into `to` don't depend on its quadric, its other neighbours keep their cheapest.
+        queueCheapest(collapse.to);
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        for(GLuint neighbour : neighbours)
+            queueCheapest(neighbour);
+    }
+
+    size_t write = 0;
+    for(size_t triangle = 0; triangle < removedTriangle.size(); ++triangle)
+    {
+        if (removedTriangle[triangle])
+            continue;
+        for(int corner = 0; corner < 3; ++corner)
+            result[write++] = result[triangle * 3 + corner];
+    }
+    result.resize(write);
+
+    if (resultError)
+        *resultError = float(std::sqrt(reachedError) / extent);
+    return result;
+}
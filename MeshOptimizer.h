@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <vector>
+
+#include "mesh.h"
+
+// How a model's meshes are conditioned when it is imported
+struct ImportOptions
+{
+    // Meshes whose vertex and index layout is relied on (see Model::SortFaces) must opt out
+    bool optimize = true;
+    // coarser index lists over the same vertices, only built for optimized meshes
+    bool generateLods = true;
+    // models that edit their meshes need a copy of their own, see AssetRegistry::GetModel
+    bool shared = true;
+    // meshes release their vertices and indices once uploaded, unless they are read later (SortFaces)
+    bool keepCpuData = false;
+    // merges the meshes sampling the same textures into one, node transforms baked into the vertices
+    bool batchStatic = false;
+};
+
+// Raw counts so that metrics of several meshes can be summed up
+struct MeshMetrics
+{
+    size_t vertices = 0;
+    size_t triangles = 0;
+    size_t cacheMisses = 0;  // simulated post-transform FIFO cache
+    size_t shadedPixels = 0; // depth tested fragments over 6 axis-aligned views
+    size_t coveredPixels = 0;
+
+    float ACMR() const { return triangles ? float(cacheMisses) / float(triangles) : 0.f; }
+    float ATVR() const { return vertices ? float(cacheMisses) / float(vertices) : 0.f; }
+    float Overdraw() const { return coveredPixels ? float(shadedPixels) / float(coveredPixels) : 0.f; }
+
+    MeshMetrics &operator+=(const MeshMetrics &other);
+};
+
+struct MeshOptimizationReport
+{
+    MeshMetrics before;
+    MeshMetrics after;
+};
+
+namespace MeshOptimizer
+{
+    // Welds identical vertices, then reorders triangles for the vertex cache and
+    // overdraw, then vertices for fetch locality. Metrics are measured before and after.
+    MeshOptimizationReport Optimize(std::vector<Vertex> &vertices, std::vector<GLuint> &indices);
+
+    void WeldVertices(std::vector<Vertex> &vertices, std::vector<GLuint> &indices);
+    // Forsyth's linear-speed vertex cache optimization
+    void OptimizeVertexCache(std::vector<GLuint> &indices, size_t vertexCount);
+    // Splits the cache-ordered triangles where the cache restarts and draws outward facing clusters first
+    void OptimizeOverdraw(std::vector<GLuint> &indices, const std::vector<Vertex> &vertices);
+    // Orders vertices by first use and drops unreferenced ones
+    void OptimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<GLuint> &indices);
+
+    // Quadric error edge collapses onto neighbouring vertices until at most targetIndexCount
+    // indices are left or the next collapse would move the surface by more than maxError,
+    // relative to the mesh size. UV seams, normal creases and open borders are kept.
+    // Returns indices into the unchanged vertices, the reached error goes to resultError.
+    std::vector<GLuint> Simplify(const std::vector<Vertex> &vertices, const std::vector<GLuint> &indices, size_t targetIndexCount, float maxError, float *resultError = nullptr);
+
+    MeshMetrics Analyze(const std::vector<Vertex> &vertices, const std::vector<GLuint> &indices);
+}
@@ -0,0 +1,209 @@
+#include "QuadBatcher.h"
+#include "AssetRegistry.h"
+#include "MemoryTracker.h"
+#include "GLState.h"
+#include "globalData.h"
+#include "shader.h"
+#include <algorithm>
+#include <cstddef>
+
+namespace
+{
+    const size_t MIN_CAPACITY = 256;
+
+    // Planes of the view frustum as (normal, distance), normals pointing inwards
+    void frustumPlanes(const glm::mat4 &viewProjection, glm::vec4 planes[6])
+    {
+        const glm::mat4 m = glm::transpose(viewProjection);
+        planes[0] = m[3] + m[0];
+        planes[1] = m[3] - m[0];
+        planes[2] = m[3] + m[1];
+        planes[3] = m[3] - m[1];
+        planes[4] = m[3] + m[2];
+        planes[5] = m[3] - m[2];
+        for(int i = 0; i < 6; ++i)
+            planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+
+    bool sphereVisible(const glm::vec4 planes[6], const glm::vec3 &center, float radius)
+    {
+        for(int i = 0; i < 6; ++i)
+            if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+                return false;
+        return true;
+    }
+
+    // whether two quads can be drawn by the same call
+    bool sameBatch(const Quad &a, const Quad &b)
+    {
+        return a.sprite.page == b.sprite.page && a.shaderID == b.shaderID && a.color == b.color
+            && a.opaque == b.opaque && a.solidColor == b.solidColor;
+    }
+}
+
+QuadBatcher::QuadBatcher()
+{
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    GLState::BindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+    GLState::BindVertexArray(0);
+}
+
+QuadBatcher::~QuadBatcher()
+{
+    if (!AssetRegistry::HasContext())
+        return;
+    GLState::DeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ebo);
+    MemoryTracker::Untrack(MEMORY_GEOMETRY, MEMORY_OBJECT_BUFFER, vbo);
+    MemoryTracker::Untrack(MEMORY_GEOMETRY, MEMORY_OBJECT_BUFFER, ebo);
+}
+
+size_t QuadBatcher::Add(const Quad &quad)
+{
+    quads.push_back(quad);
+    return quads.size() - 1;
+}
+
+void QuadBatcher::reserve(size_t quadCount)
+{
+    if (quadCount <= capacity)
+        return;
+    size_t newCapacity = std::max(capacity, MIN_CAPACITY);
+    while (newCapacity < quadCount)
+        newCapacity *= 2;
+
+    // the indices never change, two triangles per quad
+    std::vector<GLuint> indices;
+    indices.reserve(newCapacity * 6);
+    for(GLuint i = 0; i < newCapacity; ++i)
+    {
+        const GLuint corners[6] = {0, 1, 2, 1, 3, 2};
+        for(GLuint corner : corners)
+            indices.push_back(4 * i + corner);
+    }
+    GLState::BindVertexArray(vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    capacity = newCapacity;
+    MemoryTracker::Track(MEMORY_GEOMETRY, MEMORY_OBJECT_BUFFER, vbo, "quad vertices", capacity * 4 * sizeof(Vertex));
+    MemoryTracker::Track(MEMORY_GEOMETRY, MEMORY_OBJECT_BUFFER, ebo, "quad indices", capacity * 6 * sizeof(GLuint));
+}
+
+void QuadBatcher::Prepare(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &cameraPosition)
+{
+    atlas.Upload();
+
+    glm::vec4 planes[6];
+    frustumPlanes(projection * view, planes);
+    sorted.clear();
+    for(size_t i = 0; i < quads.size(); ++i)
+    {
+        const Quad &quad = quads[i];
+        if (quad.sprite.page < 0 || !sphereVisible(planes, quad.center, glm::length(quad.size) * 0.5f))
+            continue;
+        sorted.push_back(SortedQuad{glm::distance(cameraPosition, quad.center), i});
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const SortedQuad &a, const SortedQuad &b) { return a.distance > b.distance; });
+
+    stats.quads = quads.size();
+    stats.visible = sorted.size();
+    stats.drawCalls = 0;
+    stats.pages = atlas.PageCount();
+    drawn = 0;
+    if (sorted.empty())
+        return;
+
+    // rows of the view matrix are the camera axes in world space
+    const glm::vec3 cameraRight{view[0][0], view[1][0], view[2][0]};
+    const glm::vec3 cameraUp{view[0][1], view[1][1], view[2][1]};
+    vertices.clear();
+    for(const SortedQuad &entry : sorted)
+    {
+        const Quad &quad = quads[entry.quad];
+        const glm::vec3 right = (quad.billboard ? cameraRight : quad.right) * (quad.size.x * 0.5f);
+        const glm::vec3 up = (quad.billboard ? cameraUp : quad.up) * (quad.size.y * 0.5f);
+        const glm::vec3 normal = glm::normalize(glm::cross(right, up));
+        const glm::vec2 &uvMin = quad.sprite.uvMin;
+        const glm::vec2 &uvMax = quad.sprite.uvMax;
+        vertices.push_back(Vertex{quad.center - right - up, normal, glm::vec2{uvMin.x, uvMax.y}});
+        vertices.push_back(Vertex{quad.center + right - up, normal, glm::vec2{uvMax.x, uvMax.y}});
+        vertices.push_back(Vertex{quad.center - right + up, normal, glm::vec2{uvMin.x, uvMin.y}});
+        vertices.push_back(Vertex{quad.center + right + up, normal, glm::vec2{uvMax.x, uvMin.y}});
+    }
+
+    reserve(sorted.size());
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    // orphaned every frame so we never wait for last frame's draws
+    glBufferData(GL_ARRAY_BUFFER, capacity * 4 * sizeof(Vertex), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void QuadBatcher::DrawFartherThan(float distance)
+{
+    size_t first = drawn;
+    while (drawn < sorted.size() && sorted[drawn].distance > distance)
+    {
+        // a page or material change has to start a new draw, the order can't be shuffled
+        if (drawn > first && !sameBatch(quads[sorted[drawn].quad], quads[sorted[drawn - 1].quad]))
+        {
+            draw(first, drawn - first);
+            first = drawn;
+        }
+        ++drawn;
+    }
+    if (drawn > first)
+        draw(first, drawn - first);
+}
+
+void QuadBatcher::draw(size_t first, size_t count)
+{
+    const Quad &quad = quads[sorted[first].quad];
+    if (quad.shaderID < 0)
+        return;
+    Shader &baseShader = DATA.shadersManager.GetShader(quad.shaderID);
+    if (!baseShader.IsReady())
+        return;
+    Shader *shader = &baseShader;
+    if (baseShader.permutable)
+    {
+        ShaderPermutation permutation;
+        permutation.solidColor = quad.solidColor;
+        permutation.opaque = quad.opaque;
+        permutation.dirLights = DATA.dirLightsCount;
+        permutation.pointLights = DATA.pointLightsCount;
+        permutation.spotLights = DATA.spotLightsCount;
+        Shader &variant = DATA.shadersManager.GetShader(DATA.shadersManager.GetVariant(quad.shaderID, permutation));
+        if (variant.IsReady())
+            shader = &variant;
+    }
+
+    shader->use();
+    // vertices are in world space and unpacked
+    shader->set(Uniforms::model, glm::mat4{1.f});
+    shader->set(Uniforms::meshPositionScale, glm::vec3{1.f});
+    shader->set(Uniforms::meshPositionOffset, glm::vec3{0.f});
+    shader->set(Uniforms::isSolidColor, quad.solidColor);
+    shader->set(Uniforms::color, quad.color);
+    shader->set(Uniforms::opaque, quad.opaque);
+    shader->set(Uniforms::shininess, 32.f);
+    shader->set(Uniforms::diffuseSamplers[0], 0);
+    GLState::ActiveTexture(GL_TEXTURE0);
+    GLState::BindTexture(GL_TEXTURE_2D, atlas.PageTexture(quad.sprite.page));
+    GLState::StencilMask(0x00);
+
+    GLState::BindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, GLsizei(count * 6), GL_UNSIGNED_INT, (void*)(first * 6 * sizeof(GLuint)));
+    ++stats.drawCalls;
+}
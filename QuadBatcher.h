@@ -0,0 +1,83 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+#include "TextureAtlas.h"
+#include "mesh.h"
+
+struct Quad
+{
+    glm::vec3 center{0.f};
+    glm::vec2 size{1.f};
+    // world directions of the quad's width and height, billboards face the camera instead
+    glm::vec3 right{1.f, 0.f, 0.f};
+    glm::vec3 up{0.f, 1.f, 0.f};
+    bool billboard = false;
+    AtlasRegion sprite;
+
+    std::string name;
+    int shaderID = -1;
+    // material, as on Model; quads drawn in one call share all of it
+    glm::vec4 color{0.f, 0.f, 0.f, 1.f};
+    bool opaque = false;
+    bool solidColor = false;
+};
+
+struct QuadBatcherStats
+{
+    size_t quads = 0;
+    size_t visible = 0;
+    size_t drawCalls = 0;
+    size_t pages = 0;
+};
+
+// Textured quads drawn through one streaming vertex buffer. Every frame Prepare culls them,
+// sorts the visible ones back to front and uploads their vertices at once; the Draw calls
+// then emit one draw call per run of quads sharing an atlas page, shader and material.
+class QuadBatcher
+{
+public:
+    QuadBatcher();
+    ~QuadBatcher();
+    QuadBatcher(const QuadBatcher&) = delete;
+    QuadBatcher& operator=(const QuadBatcher&) = delete;
+
+    AtlasRegion AddSprite(const std::string &path) { return atlas.Add(path); }
+    // Returns the index of the quad, see GetQuad
+    size_t Add(const Quad &quad);
+    Quad &GetQuad(size_t index) { return quads[index]; }
+    size_t QuadCount() const { return quads.size(); }
+
+    void Prepare(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &cameraPosition);
+    // Draws the prepared quads farther from the camera than `distance` that aren't drawn yet,
+    // call before each sorted transparent model so that they interleave correctly
+    void DrawFartherThan(float distance);
+    void DrawRemaining() { DrawFartherThan(-1.f); }
+
+    const QuadBatcherStats &Stats() const { return stats; }
+
+private:
+    struct SortedQuad
+    {
+        float distance;
+        size_t quad;
+    };
+
+    TextureAtlas atlas;
+    std::vector<Quad> quads;
+    std::vector<SortedQuad> sorted; // visible ones, farthest first
+    size_t drawn = 0;               // sorted quads already drawn this frame
+    std::vector<Vertex> vertices;   // of the sorted quads, kept to reuse its memory
+    QuadBatcherStats stats;
+
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLuint ebo = 0;
+    size_t capacity = 0; // quads the buffers hold
+
+    void reserve(size_t quadCount);
+    void draw(size_t first, size_t count);
+};
@@ -0,0 +1,81 @@
+#include "RangeAllocator.h"
+#include <algorithm>
+
+void RangeAllocator::Grow(size_t newCapacity)
+{
+    if (newCapacity <= capacity)
+        return;
+    size_t oldCapacity = capacity;
+    capacity = newCapacity;
+    // released like an allocation so that it merges with a free block at the old end
+    used += newCapacity - oldCapacity;
+    Free(oldCapacity, newCapacity - oldCapacity);
+}
+
+size_t RangeAllocator::Allocate(size_t size, size_t alignment/* = 1*/)
+{
+    if (size == 0)
+        return INVALID_OFFSET;
+
+    auto best = freeBlocks.end();
+    size_t bestOffset = INVALID_OFFSET;
+    for(auto it = freeBlocks.begin(); it != freeBlocks.end(); ++it)
+    {
+        const size_t aligned = (it->first + alignment - 1) / alignment * alignment;
+        if (aligned + size > it->first + it->second)
+            continue;
+        if (best == freeBlocks.end() || it->second < best->second)
+        {
+            best = it;
+            bestOffset = aligned;
+            if (it->second == size)
+                break;
+        }
+    }
+    if (best == freeBlocks.end())
+        return INVALID_OFFSET;
+
+    const size_t blockOffset = best->first;
+    const size_t blockEnd = best->first + best->second;
+    freeBlocks.erase(best);
+    if (bestOffset > blockOffset)
+        freeBlocks[blockOffset] = bestOffset - blockOffset;
+    if (bestOffset + size < blockEnd)
+        freeBlocks[bestOffset + size] = blockEnd - (bestOffset + size);
+
+    used += size;
+    return bestOffset;
+}
+
+void RangeAllocator::Free(size_t offset, size_t size)
+{
+    if (size == 0 || offset == INVALID_OFFSET)
+        return;
+    used -= size;
+
+    auto next = freeBlocks.lower_bound(offset);
+    if (next != freeBlocks.begin())
+    {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            size += prev->second;
+            freeBlocks.erase(prev);
+        }
+    }
+    if (next != freeBlocks.end() && offset + size == next->first)
+    {
+        size += next->second;
+        freeBlocks.erase(next);
+    }
+    freeBlocks[offset] = size;
+}
+
+size_t RangeAllocator::LargestFreeBlock() const
+{
+    size_t largest = 0;
+    for(const auto& block : freeBlocks)
+        largest = std::max(largest, block.second);
+    return largest;
+}
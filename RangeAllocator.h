@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+// Hands out [offset, offset + size) ranges of an abstract linear space. Best fit,
+// freed ranges are merged with their free neighbours.
+class RangeAllocator
+{
+public:
+    static constexpr size_t INVALID_OFFSET = SIZE_MAX;
+
+    // Appends [Capacity(), newCapacity) to the free space
+    void Grow(size_t newCapacity);
+    // Returns INVALID_OFFSET if no free block is large enough
+    size_t Allocate(size_t size, size_t alignment = 1);
+    void Free(size_t offset, size_t size);
+
+    size_t Capacity() const { return capacity; }
+    size_t Used() const { return used; }
+    size_t FreeBlocksCount() const { return freeBlocks.size(); }
+    size_t LargestFreeBlock() const;
+
+private:
+    std::map<size_t, size_t> freeBlocks; // offset -> size
+    size_t capacity = 0;
+    size_t used = 0;
+};
@@ -0,0 +1,110 @@
+#include "SceneLoader.h"
+#include "model.h"
+#include "ImportedModel.h"
+#include "Trace.h"
+#include <algorithm>
+
+namespace
+{
+    // textures only get their 1x1 level here, TextureStreamer has its own budget
+    size_t uploadBytes(const ImportedModel &imported, size_t mesh)
+    {
+        const MeshGeometry &geometry = imported.meshes[mesh].geometry;
+        return geometry.vertexCount * GeometryArena::VertexStride(geometry.format)
+             + geometry.indexCount * GeometryArena::IndexSize(GeometryArena::IndexType(geometry.vertexCount));
+    }
+}
+
+SceneLoader::SceneLoader(unsigned threadCount/* = 0*/)
+    : pool(threadCount)
+{
+}
+
+void SceneLoader::LoadModel(Model *model, const std::string &path, const ImportOptions &options)
+{
+    if (std::shared_ptr<const ModelAsset> asset = AssetRegistry::FindModel(path, options))
+    {
+        model->SetAsset(asset);
+        return;
+    }
+
+    const std::string key = AssetRegistry::ModelKey(path, options);
+    if (options.shared)
+    {
+        auto shared = sharedJobs.find(key);
+        if (shared != sharedJobs.end())
+        {
+            shared->second->models.push_back(model);
+            return;
+        }
+    }
+
+    auto job = std::make_shared<Job>();
+    job->path = path;
+    job->options = options;
+    job->models.push_back(model);
+    jobs.push_back(job);
+    if (options.shared)
+        sharedJobs[key] = job;
+
+    // the worker only reads path and options, which don't change after this
+    pool.Submit([this, job]() {
+        std::unique_ptr<ImportedModel> imported = Model::Read(job->path, job->options);
+        std::lock_guard<std::mutex> lock(finishedMutex);
+        job->imported = std::move(imported);
+        finished.push_back(job);
+    });
+}
+
+size_t SceneLoader::Update(size_t budgetBytes)
+{
+    size_t uploaded = 0;
+    bool uploadedAny = false;
+    for(;;)
+    {
+        std::shared_ptr<Job> job;
+        {
+            std::lock_guard<std::mutex> lock(finishedMutex);
+            if (finished.empty())
+                break;
+            job = finished.front();
+        }
+
+        const ImportedModel &imported = *job->imported;
+        if (!job->asset)
+        {
+            job->asset = std::make_shared<ModelAsset>();
+            job->asset->directory = imported.directory;
+        }
+        while (job->asset->meshes.size() < imported.meshes.size() && (uploaded < budgetBytes || !uploadedAny))
+        {
+            const size_t mesh = job->asset->meshes.size();
+            TraceScope trace("model", "Upload " + imported.meshes[mesh].name);
+            uploaded += uploadBytes(imported, mesh);
+            job->asset->meshes.push_back(Model::UploadMesh(imported, mesh));
+            uploadedAny = true;
+        }
+        if (job->asset->meshes.size() < imported.meshes.size())
+            break;
+
+        {
+            std::lock_guard<std::mutex> lock(finishedMutex);
+            finished.pop_front();
+        }
+        complete(job);
+    }
+    return jobs.size();
+}
+
+void SceneLoader::complete(const std::shared_ptr<Job> &job)
+{
+    AssetRegistry::AddModel(job->path, job->options, job->asset);
+    for(Model *model : job->models)
+        model->SetAsset(job->asset);
+
+    // frees the CPU copies and unmaps the baked file
+    job->imported.reset();
+    if (job->options.shared)
+        sharedJobs.erase(AssetRegistry::ModelKey(job->path, job->options));
+    jobs.erase(std::find(jobs.begin(), jobs.end(), job));
+}
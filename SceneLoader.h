@@ -0,0 +1,53 @@
+#pragma once
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "MeshOptimizer.h"
+
+class Model;
+struct ImportedModel;
+struct ModelAsset;
+
+// Imports models on a worker pool while the GL thread keeps rendering. Finished imports
+// wait in a queue that Update uploads from, a few meshes per frame.
+class SceneLoader
+{
+public:
+    explicit SceneLoader(unsigned threadCount = 0);
+
+    // `model` gets its asset once uploaded and must stay alive until then.
+    // Models asking for the same shared import wait for a single one.
+    void LoadModel(Model *model, const std::string &path, const ImportOptions &options);
+
+    // GL thread. Uploads finished imports until `budgetBytes` of geometry went
+    // to the GPU, at least one mesh. Returns the imports left.
+    size_t Update(size_t budgetBytes);
+    size_t PendingCount() const { return jobs.size(); }
+
+private:
+    struct Job
+    {
+        std::string path;
+        ImportOptions options;
+        std::vector<Model*> models;
+        std::unique_ptr<ImportedModel> imported; // set by the worker
+        std::shared_ptr<ModelAsset> asset;       // filled mesh by mesh on the GL thread
+    };
+
+    std::vector<std::shared_ptr<Job>> jobs; // in submission order, GL thread only
+    std::map<std::string, std::shared_ptr<Job>> sharedJobs; // by AssetRegistry::ModelKey
+
+    std::mutex finishedMutex;
+    std::deque<std::shared_ptr<Job>> finished; // imported, waiting for upload
+
+    // last, so that the workers are joined before anything they touch is destroyed
+    ThreadPool pool;
+
+    void complete(const std::shared_ptr<Job> &job);
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Compile-time specialization of a shader that declares `#pragma permutable`.
+// Each field becomes a #define, see shaders/fragment.glsl.
+struct ShaderPermutation
+{
+    bool solidColor = false;
+    bool opaque = false;
+    bool specularMap = false;
+    int dirLights = 0;
+    int pointLights = 0;
+    int spotLights = 0;
+    bool instanced = false; // per-instance attributes replace the model uniforms
+
+    uint32_t Key() const
+    {
+        return uint32_t(solidColor)
+            | uint32_t(opaque) << 1
+            | uint32_t(specularMap) << 2
+            | uint32_t(dirLights & 0xF) << 3
+            | uint32_t(pointLights & 0xF) << 7
+            | uint32_t(spotLights & 0xF) << 11
+            | uint32_t(instanced) << 15;
+    }
+
+    std::string Defines() const
+    {
+        std::string defines = "#define PERMUTATION\n";
+        if (solidColor)
+            defines += "#define SOLID_COLOR\n";
+        if (opaque)
+            defines += "#define OPAQUE\n";
+        if (specularMap)
+            defines += "#define HAS_SPECULAR_MAP\n";
+        if (instanced)
+            defines += "#define INSTANCED\n";
+        defines += "#define DIR_LIGHTS_COUNT " + std::to_string(dirLights) + "\n";
+        defines += "#define POINT_LIGHTS_COUNT " + std::to_string(pointLights) + "\n";
+        defines += "#define SPOT_LIGHTS_COUNT " + std::to_string(spotLights) + "\n";
+        return defines;
+    }
+};
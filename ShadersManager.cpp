@@ -1,31 +1,87 @@
-#include "ShadersManager.h"
-#include "shader.h"
-
-int ShadersManager::NEXT_ID = 1;
-
-int ShadersManager::AddShader(Shader && shader)
-{
-    shaders.insert({NEXT_ID, shader});
-    return NEXT_ID++;
-}
-
-int ShadersManager::CreateShader(const GLchar* vertexPath, const GLchar* fragmentPath)
-{
-    Shader shader{vertexPath, fragmentPath};
-    return AddShader(std::move(shader));
-}
-
-int ShadersManager::GetShaderID(const GLchar* vertexPath, const GLchar* fragmentPath)
-{
-    auto it = std::find_if(shaders.begin(), shaders.end(), [vertexPath, fragmentPath](const std::pair<int, Shader>& p){
-        return p.second.vShaderName == vertexPath && p.second.fShaderName == fragmentPath;
-    });
-    if (it != shaders.end())
-        return it->first;
-    return CreateShader(vertexPath, fragmentPath);
-}
-
-Shader& ShadersManager::GetShader(int id)
-{
-    return shaders.at(id);
+#include "ShadersManager.h"
+#include "shader.h"
+#include <algorithm>
+#include "GLExtensions.h"
+
+int ShadersManager::NEXT_ID = 1;
+
+int ShadersManager::AddShader(Shader && shader)
+{
+    if (!asyncCompile)
+        shader.Finish();
+    if (shader.IsPending())
+        pending.push_back(NEXT_ID);
+    shaders.emplace(NEXT_ID, std::move(shader));
+    return NEXT_ID++;
+}
+
+int ShadersManager::CreateShader(const GLchar* vertexPath, const GLchar* fragmentPath)
+{
+    Shader shader{vertexPath, fragmentPath};
+    return AddShader(std::move(shader));
+}
+
+size_t ShadersManager::PollPending()
+{
+    const bool blocking = !GLExt::parallelShaderCompile;
+    for(auto it = pending.begin(); it != pending.end();)
+    {
+        Shader& shader = GetShader(*it);
+        shader.Poll();
+        if (!shader.IsPending())
+        {
+            it = pending.erase(it);
+            if (blocking)
+                break;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    return pending.size();
+}
+
+void ShadersManager::FinishAll()
+{
+    for(int id : pending)
+        GetShader(id).Finish();
+    pending.clear();
+}
+
+int ShadersManager::GetShaderID(const GLchar* vertexPath, const GLchar* fragmentPath)
+{
+    // Shader keeps only file names, so callers may pass either names or paths
+    std::string vShaderName{vertexPath};
+    vShaderName = vShaderName.substr(vShaderName.find_last_of('/') + 1);
+    std::string fShaderName{fragmentPath};
+    fShaderName = fShaderName.substr(fShaderName.find_last_of('/') + 1);
+    auto it = std::find_if(shaders.begin(), shaders.end(), [&vShaderName, &fShaderName](const std::pair<const int, Shader>& p){
+        return !p.second.IsVariant() && p.second.vShaderName == vShaderName && p.second.fShaderName == fShaderName;
+    });
+    if (it != shaders.end())
+        return it->first;
+    return CreateShader(vertexPath, fragmentPath);
+}
+
+int ShadersManager::GetVariant(int baseID, const ShaderPermutation& permutation)
+{
+    const uint64_t key = uint64_t(baseID) << 32 | permutation.Key();
+    auto it = variants.find(key);
+    if (it != variants.end())
+        return it->second;
+
+    const Shader& base = GetShader(baseID);
+    if (!base.permutable)
+        return variants[key] = baseID;
+
+    std::string vertexPath = base.vertexPath, fragmentPath = base.fragmentPath;
+    int variantID = AddShader(Shader{vertexPath.c_str(), fragmentPath.c_str(), permutation.Defines()});
+    variants[key] = variantID;
+    return variantID;
+}
+
+Shader& ShadersManager::GetShader(int id)
+{
+    return shaders.at(id);
 }
\ No newline at end of file
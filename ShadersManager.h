@@ -1,59 +1,78 @@
-#pragma once
-#include <map>
-#include <string>
-#include <glm/glm.hpp>
-#include <glad/glad.h>
-
-#include "shader.h"
-
-#define SET_TO_ALL_SHADERS(setFunc, ...) setFunc(__VA_ARGS__)
-
-class ShadersManager
-{
-    static int NEXT_ID;
-    std::map<int, Shader> shaders;
-public:
-    int AddShader(Shader && shader);
-    int CreateShader(const GLchar* vertexPath, const GLchar* fragmentPath);
-    int GetShaderID(const GLchar* vertexPath, const GLchar* fragmentPath);
-
-    template<typename T>
-    void set(const std::string &name, const T& value)
-    {
-        for(auto& id_shader : shaders)
-        {
-            Shader& shader = id_shader.second;
-            shader.use();
-            shader.set(name, value);
-        }
-    }
-    
-    template<typename T>
-    void set3(const std::string &name, const T& value1, const T& value2, const T& value3)
-    {
-        for(auto& id_shader : shaders)
-        {
-            Shader& shader = id_shader.second;
-            shader.use();
-            shader.set(name, value1, value2, value3);
-        }
-    }
-    
-    template<typename T>
-    void set4(const std::string &name, const T& value1, const T& value2, const T& value3, const T& value4)
-    {
-        for(auto& id_shader : shaders)
-        {
-            Shader& shader = id_shader.second;
-            shader.use();
-            shader.set(name, value1, value2, value3, value4);
-        }
-    }
-
-    void setMat4(const std::string &name, const glm::mat4 &mat);
-    void setVec3(const std::string &name, float x, float y, float z);
-    void setVec3(const std::string &name, const glm::vec3 &vec);
-
-    class Shader& GetShader(int id);
-
+#pragma once
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+#include "shader.h"
+#include "ShaderPermutation.h"
+
+#define SET_TO_ALL_SHADERS(setFunc, ...) setFunc(__VA_ARGS__)
+
+class ShadersManager
+{
+    static int NEXT_ID;
+    std::map<int, Shader> shaders;
+    std::unordered_map<uint64_t, int> variants; // base id << 32 | permutation key -> variant id
+    std::vector<int> pending; // ids of programs still compiling
+public:
+    // Programs are compiled in the background and picked up by PollPending.
+    // When false every program is finished before CreateShader returns.
+    bool asyncCompile = true;
+
+    int AddShader(Shader && shader);
+    int CreateShader(const GLchar* vertexPath, const GLchar* fragmentPath);
+    int GetShaderID(const GLchar* vertexPath, const GLchar* fragmentPath);
+    // Returns the specialized variant of a permutable shader, compiling it on first use.
+    // Shaders that aren't permutable are returned as is.
+    int GetVariant(int baseID, const ShaderPermutation& permutation);
+
+    // Collects programs that finished compiling, returns how many are still pending.
+    // Without KHR_parallel_shader_compile this blocks on at most one program per call.
+    size_t PollPending();
+    void FinishAll();
+    size_t PendingCount() const { return pending.size(); }
+    bool IsReady(int id) { return GetShader(id).IsReady(); }
+
+    template<typename T>
+    void set(UniformName name, const T& value)
+    {
+        for(auto& id_shader : shaders)
+        {
+            Shader& shader = id_shader.second;
+            shader.use();
+            shader.set(name, value);
+        }
+    }
+    
+    template<typename T>
+    void set3(UniformName name, const T& value1, const T& value2, const T& value3)
+    {
+        for(auto& id_shader : shaders)
+        {
+            Shader& shader = id_shader.second;
+            shader.use();
+            shader.set(name, value1, value2, value3);
+        }
+    }
+    
+    template<typename T>
+    void set4(UniformName name, const T& value1, const T& value2, const T& value3, const T& value4)
+    {
+        for(auto& id_shader : shaders)
+        {
+            Shader& shader = id_shader.second;
+            shader.use();
+            shader.set(name, value1, value2, value3, value4);
+        }
+    }
+
+    void setMat4(const std::string &name, const glm::mat4 &mat);
+    void setVec3(const std::string &name, float x, float y, float z);
+    void setVec3(const std::string &name, const glm::vec3 &vec);
+
+    class Shader& GetShader(int id);
+
 };
\ No newline at end of file
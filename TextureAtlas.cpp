@@ -0,0 +1,134 @@
+#include "TextureAtlas.h"
+#include "AssetRegistry.h"
+#include "GLState.h"
+#include "MemoryTracker.h"
+#include "TextureStreamer.h"
+#include "model.h"
+#include <algorithm>
+
+// ImGui compiles its copy as static, this one is private to the atlas
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imstb_rectpack.h"
+
+struct TextureAtlas::Page
+{
+    int width = 0;
+    int height = 0;
+    std::vector<GLubyte> pixels; // RGBA
+    stbrp_context context;
+    std::vector<stbrp_node> nodes; // referenced by context, so pages are never moved
+    GLuint texture = 0;
+    bool dirty = true;
+};
+
+namespace
+{
+    void deleteTexture(GLuint texture)
+    {
+        if (!texture || !AssetRegistry::HasContext())
+            return;
+        TextureStreamer::Cancel(texture);
+        GLState::DeleteTextures(1, &texture);
+        MemoryTracker::Untrack(MEMORY_TEXTURES, MEMORY_OBJECT_TEXTURE, texture);
+    }
+}
+
+TextureAtlas::TextureAtlas() = default;
+
+TextureAtlas::~TextureAtlas()
+{
+    for(const auto &page : pages)
+        deleteTexture(page->texture);
+}
+
+GLuint TextureAtlas::PageTexture(int page) const
+{
+    return pages[page]->texture;
+}
+
+TextureAtlas::Page &TextureAtlas::newPage(int width, int height)
+{
+    pages.push_back(std::make_unique<Page>());
+    Page &page = *pages.back();
+    page.width = width;
+    page.height = height;
+    page.pixels.assign(size_t(width) * height * 4, 0);
+    page.nodes.resize(width);
+    stbrp_init_target(&page.context, width, height, page.nodes.data(), (int)page.nodes.size());
+    return page;
+}
+
+AtlasRegion TextureAtlas::Add(const std::string &path)
+{
+    auto found = regions.find(path);
+    if (found != regions.end())
+        return found->second;
+
+    AtlasRegion region;
+    // the page gets its own mips, the image's are of no use
+    const TextureImage image = DecodeTexture(path.c_str(), "", true, false);
+    if (image.LevelCount() == 0)
+        return regions[path] = region;
+
+    stbrp_rect rect = {};
+    rect.w = image.width + 2 * PADDING;
+    rect.h = image.height + 2 * PADDING;
+    for(size_t i = 0; i < pages.size() && !rect.was_packed; ++i)
+    {
+        stbrp_pack_rects(&pages[i]->context, &rect, 1);
+        region.page = (int)i;
+    }
+    if (!rect.was_packed)
+    {
+        // images bigger than a page get one of their own size
+        Page &page = newPage(std::max<int>(PAGE_SIZE, rect.w), std::max<int>(PAGE_SIZE, rect.h));
+        stbrp_pack_rects(&page.context, &rect, 1);
+        region.page = (int)pages.size() - 1;
+    }
+
+    Page &page = *pages[region.page];
+    const GLubyte *src = image.LevelPixels(0);
+    const int channels = image.channels;
+    for(int y = 0; y < rect.h; ++y)
+    {
+        const int srcY = std::min(std::max(y - PADDING, 0), image.height - 1);
+        for(int x = 0; x < rect.w; ++x)
+        {
+            const int srcX = std::min(std::max(x - PADDING, 0), image.width - 1);
+            const GLubyte *texel = src + (size_t(srcY) * image.width + srcX) * channels;
+            GLubyte *out = page.pixels.data() + ((size_t(rect.y) + y) * page.width + rect.x + x) * 4;
+            out[0] = texel[0];
+            out[1] = channels >= 3 ? texel[1] : texel[0];
+            out[2] = channels >= 3 ? texel[2] : texel[0];
+            out[3] = channels == 4 ? texel[3] : channels == 2 ? texel[1] : 255;
+        }
+    }
+    page.dirty = true;
+
+    region.uvMin = glm::vec2{float(rect.x + PADDING) / page.width, float(rect.y + PADDING) / page.height};
+    region.uvMax = glm::vec2{float(rect.x + PADDING + image.width) / page.width, float(rect.y + PADDING + image.height) / page.height};
+    return regions[path] = region;
+}
+
+void TextureAtlas::Upload()
+{
+    for(size_t i = 0; i < pages.size(); ++i)
+    {
+        Page &page = *pages[i];
+        if (!page.dirty)
+            continue;
+        page.dirty = false;
+
+        auto image = std::make_shared<TextureImage>();
+        image->filename = "atlas page " + std::to_string(i);
+        image->width = page.width;
+        image->height = page.height;
+        image->channels = 4;
+        image->pixels = page.pixels;
+        image->levelOffsets = {0};
+        GenerateMipmaps(*image, true);
+        // respecified in place, a new name could be one GLState still thinks is bound
+        page.texture = TextureStreamer::Create(std::move(image), page.texture);
+    }
+}
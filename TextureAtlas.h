@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Where an image ended up in the atlas, v grows downwards like in the image file
+struct AtlasRegion
+{
+    int page = -1;
+    glm::vec2 uvMin{0.f};
+    glm::vec2 uvMax{1.f};
+};
+
+// Images packed into shared RGBA pages with stb_rectpack. Each image is surrounded by
+// copies of its edge texels so that filtering and the first mips don't bleed in neighbours.
+// Pages stay on the CPU, images added later are packed into them and the page re-uploaded.
+class TextureAtlas
+{
+public:
+    static const int PAGE_SIZE = 2048;
+    static const int PADDING = 4;
+
+    TextureAtlas();
+    ~TextureAtlas();
+    TextureAtlas(const TextureAtlas&) = delete;
+    TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+    // Decodes `path` the first time, page -1 if it can't be read
+    AtlasRegion Add(const std::string &path);
+    // GL thread, recreates the textures of pages that changed
+    void Upload();
+
+    GLuint PageTexture(int page) const;
+    size_t PageCount() const { return pages.size(); }
+
+private:
+    struct Page;
+    std::vector<std::unique_ptr<Page>> pages;
+    std::map<std::string, AtlasRegion> regions;
+
+    Page &newPage(int width, int height);
+};
@@ -0,0 +1,148 @@
+#include "TextureCache.h"
+#include "TextureImage.h"
+#include "TextureCompressor.h"
+#include "FileUtils.h"
+#include "Hash.h"
+#include <cstring>
+#include <iostream>
+
+std::string TextureCache::cacheDirectory = "texture_cache";
+
+namespace
+{
+    const char TEXTURE_CACHE_MAGIC[4] = {'T', 'E', 'X', 'C'};
+    const uint32_t TEXTURE_CACHE_VERSION = 1;
+    const size_t LEVEL_ALIGNMENT = 16;
+
+    // File layout: header, one record per mip level from the largest, then the 16-byte aligned levels.
+    // Offsets are from the start of the file.
+    struct FileHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t sourceHash;
+        uint32_t width;
+        uint32_t height;
+        uint32_t channels;
+        uint32_t compressedFormat;
+        uint32_t levelCount;
+        uint32_t padding;
+    };
+
+    struct LevelRecord
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    template<typename T>
+    void append(std::vector<char> &file, const T &value)
+    {
+        file.insert(file.end(), (const char*)&value, (const char*)(&value + 1));
+    }
+
+    template<typename T>
+    T read(const unsigned char *data)
+    {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+}
+
+std::string TextureCache::CachePath(const std::string &sourcePath, bool srgb, bool compress)
+{
+    uint64_t key = Hash64(sourcePath);
+    const bool flags[] = {srgb, compress};
+    key = Hash64(flags, sizeof(flags), key);
+    return cacheDirectory + "/" + HashToString(key) + ".tex";
+}
+
+bool TextureCache::Read(const std::string &cachePath, uint64_t sourceHash, TextureImage &image)
+{
+    if (cacheDirectory.empty())
+        return false;
+    auto file = std::make_shared<MappedFile>();
+    if (!file->Open(cachePath) || file->Size() < sizeof(FileHeader))
+        return false;
+    const unsigned char *data = file->Data();
+    const size_t size = file->Size();
+
+    const FileHeader header = read<FileHeader>(data);
+    if (std::memcmp(header.magic, TEXTURE_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != TEXTURE_CACHE_VERSION || header.sourceHash != sourceHash)
+        return false;
+    if (header.width == 0 || header.height == 0 || header.width > 65536 || header.height > 65536 || header.channels == 0 || header.channels > 4
+        || header.levelCount != (uint32_t)TextureImage::MipCount((int)header.width, (int)header.height))
+        return false;
+    // cooked on a GL that could sample it, this one may not
+    if (header.compressedFormat && !TextureCompressor::IsSupported(header.compressedFormat))
+        return false;
+    if (sizeof(FileHeader) + header.levelCount * sizeof(LevelRecord) > size)
+        return false;
+
+    std::vector<size_t> offsets;
+    for(uint32_t level = 0; level < header.levelCount; ++level)
+    {
+        const LevelRecord record = read<LevelRecord>(data + sizeof(FileHeader) + level * sizeof(LevelRecord));
+        const int width = std::max((int)header.width >> level, 1);
+        const int height = std::max((int)header.height >> level, 1);
+        if (record.size != TextureImage::LevelBytes(header.compressedFormat, (int)header.channels, width, height)
+            || record.offset > size || record.size > size - record.offset)
+            return false;
+        offsets.push_back((size_t)record.offset);
+    }
+
+    image.width = (int)header.width;
+    image.height = (int)header.height;
+    image.channels = (int)header.channels;
+    image.compressedFormat = header.compressedFormat;
+    image.pixels.clear();
+    image.levelOffsets = std::move(offsets);
+    image.cooked = std::move(file);
+    return true;
+}
+
+bool TextureCache::Save(const std::string &cachePath, uint64_t sourceHash, const TextureImage &image)
+{
+    if (cacheDirectory.empty() || image.LevelCount() == 0)
+        return false;
+
+    const int levels = image.LevelCount();
+    std::vector<LevelRecord> records;
+    size_t offset = sizeof(FileHeader) + levels * sizeof(LevelRecord);
+    for(int level = 0; level < levels; ++level)
+    {
+        offset = (offset + LEVEL_ALIGNMENT - 1) / LEVEL_ALIGNMENT * LEVEL_ALIGNMENT;
+        records.push_back(LevelRecord{offset, image.LevelBytes(level)});
+        offset += image.LevelBytes(level);
+    }
+
+    FileHeader header = {};
+    std::memcpy(header.magic, TEXTURE_CACHE_MAGIC, sizeof(header.magic));
+    header.version = TEXTURE_CACHE_VERSION;
+    header.sourceHash = sourceHash;
+    header.width = (uint32_t)image.width;
+    header.height = (uint32_t)image.height;
+    header.channels = (uint32_t)image.channels;
+    header.compressedFormat = (uint32_t)image.compressedFormat;
+    header.levelCount = (uint32_t)levels;
+
+    std::vector<char> file;
+    file.reserve(offset);
+    append(file, header);
+    for(const LevelRecord &record : records)
+        append(file, record);
+    for(int level = 0; level < levels; ++level)
+    {
+        file.resize(records[level].offset, 0);
+        const char *pixels = (const char*)image.LevelPixels(level);
+        file.insert(file.end(), pixels, pixels + image.LevelBytes(level));
+    }
+
+    if (!EnsureDirectory(cacheDirectory) || !WriteFile(cachePath, file.data(), file.size()))
+    {
+        std::cerr << "ERROR::TEXTURE_CACHE::WRITE_FAILED " << cachePath << std::endl;
+        return false;
+    }
+    return true;
+}
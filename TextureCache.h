@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct TextureImage;
+
+// Cooked .tex files: the whole mip chain of a texture, optionally BCn compressed, ready
+// for upload. A file is used only while the hash of its source matches, reading maps it
+// and the levels are streamed straight from the mapping.
+class TextureCache
+{
+public:
+    static std::string cacheDirectory; // empty disables the cache
+
+    // Different mip filtering and compression cook to different files
+    static std::string CachePath(const std::string &sourcePath, bool srgb, bool compress);
+
+    // Points the levels of `image` into the mapped file, leaves it untouched on failure
+    static bool Read(const std::string &cachePath, uint64_t sourceHash, TextureImage &image);
+    static bool Save(const std::string &cachePath, uint64_t sourceHash, const TextureImage &image);
+};
@@ -0,0 +1,336 @@
+#include "TextureCompressor.h"
+#include "TextureImage.h"
+#include "GLExtensions.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+
+bool TextureCompressor::enabled = true;
+
+namespace
+{
+    // The pool is separate from the scene loader's, whose workers wait here
+    ThreadPool &encoderPool()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    // Runs body(begin, end) over [0, count) in chunks and waits for all of them
+    void parallelFor(int count, const std::function<void(int, int)> &body)
+    {
+        ThreadPool &pool = encoderPool();
+        const int chunks = std::min(count, (int)pool.ThreadCount() * 4);
+        if (chunks <= 1)
+        {
+            body(0, count);
+            return;
+        }
+        std::mutex mutex;
+        std::condition_variable done;
+        int left = chunks;
+        for(int chunk = 0; chunk < chunks; ++chunk)
+        {
+            const int begin = int(int64_t(count) * chunk / chunks);
+            const int end = int(int64_t(count) * (chunk + 1) / chunks);
+            pool.Submit([&, begin, end]() {
+                body(begin, end);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--left == 0)
+                    done.notify_one();
+            });
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&left]() { return left == 0; });
+    }
+
+    // 4x4 texels with the edges clamped, 4 channels each
+    struct Block
+    {
+        GLubyte texels[16][4];
+    };
+
+    Block loadBlock(const GLubyte *pixels, int width, int height, int channels, int blockX, int blockY)
+    {
+        Block block = {};
+        for(int i = 0; i < 16; ++i)
+        {
+            const int x = std::min(blockX * 4 + i % 4, width - 1);
+            const int y = std::min(blockY * 4 + i / 4, height - 1);
+            std::memcpy(block.texels[i], pixels + (size_t(y) * width + x) * channels, channels);
+        }
+        return block;
+    }
+
+    uint16_t toRgb565(const float color[3])
+    {
+        const int r = std::min(std::max(int(color[0] * 31.f / 255.f + 0.5f), 0), 31);
+        const int g = std::min(std::max(int(color[1] * 63.f / 255.f + 0.5f), 0), 63);
+        const int b = std::min(std::max(int(color[2] * 31.f / 255.f + 0.5f), 0), 31);
+        return uint16_t(r << 11 | g << 5 | b);
+    }
+
+    void fromRgb565(uint16_t color, int out[3])
+    {
+        const int r = color >> 11 & 31, g = color >> 5 & 63, b = color & 31;
+        out[0] = r << 3 | r >> 2;
+        out[1] = g << 2 | g >> 4;
+        out[2] = b << 3 | b >> 2;
+    }
+
+    // Endpoints are the extremes of the texels along their principal axis
+    void encodeColorBlock(const Block &block, GLubyte *out)
+    {
+        float mean[3] = {};
+        for(const auto &texel : block.texels)
+            for(int c = 0; c < 3; ++c)
+                mean[c] += texel[c] / 16.f;
+        float covariance[6] = {};
+        for(const auto &texel : block.texels)
+        {
+            const float d[3] = {texel[0] - mean[0], texel[1] - mean[1], texel[2] - mean[2]};
+            covariance[0] += d[0] * d[0]; covariance[1] += d[0] * d[1]; covariance[2] += d[0] * d[2];
+            covariance[3] += d[1] * d[1]; covariance[4] += d[1] * d[2]; covariance[5] += d[2] * d[2];
+        }
+        // Seed with the bounding box diagonal, oriented along the largest variance channel,
+        // so colour that varies orthogonally to grey does not collapse to the mean
+        float minColor[3] = {255.f, 255.f, 255.f}, maxColor[3] = {};
+        for(const auto &texel : block.texels)
+            for(int c = 0; c < 3; ++c)
+            {
+                minColor[c] = std::min(minColor[c], float(texel[c]));
+                maxColor[c] = std::max(maxColor[c], float(texel[c]));
+            }
+        const float variance[3] = {covariance[0], covariance[3], covariance[5]};
+        const int widest = int(std::max_element(variance, variance + 3) - variance);
+        const float covariances[3][3] = {
+            {covariance[0], covariance[1], covariance[2]},
+            {covariance[1], covariance[3], covariance[4]},
+            {covariance[2], covariance[4], covariance[5]}
+        };
+        float seed[3];
+        for(int c = 0; c < 3; ++c)
+        {
+            seed[c] = maxColor[c] - minColor[c];
+            if (covariances[widest][c] < 0.f)
+                seed[c] = -seed[c];
+        }
+        if (seed[0] == 0.f && seed[1] == 0.f && seed[2] == 0.f)
+            seed[0] = seed[1] = seed[2] = 1.f;
+
+        float axis[3] = {seed[0], seed[1], seed[2]};
+        for(int iteration = 0; iteration < 8; ++iteration)
+        {
+            const float next[3] = {
+                covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+                covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+                covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]
+            };
+            const float length = std::max(std::max(std::abs(next[0]), std::abs(next[1])), std::abs(next[2]));
+            if (length == 0.f)
+            {
+                std::copy(seed, seed + 3, axis);
+                break;
+            }
+            for(int c = 0; c < 3; ++c)
+                axis[c] = next[c] / length;
+        }
+
+        float minProjection = 1e30f, maxProjection = -1e30f;
+        for(const auto &texel : block.texels)
+        {
+            const float projection = (texel[0] - mean[0]) * axis[0] + (texel[1] - mean[1]) * axis[1] + (texel[2] - mean[2]) * axis[2];
+            minProjection = std::min(minProjection, projection);
+            maxProjection = std::max(maxProjection, projection);
+        }
+        const float axisLength2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+        float high[3], low[3];
+        for(int c = 0; c < 3; ++c)
+        {
+            high[c] = mean[c] + axis[c] * maxProjection / axisLength2;
+            low[c] = mean[c] + axis[c] * minProjection / axisLength2;
+        }
+
+        uint16_t color0 = toRgb565(high), color1 = toRgb565(low);
+        // color0 > color1 selects the four color mode
+        if (color0 < color1)
+            std::swap(color0, color1);
+        uint32_t indices = 0;
+        if (color0 != color1)
+        {
+            int palette[4][3];
+            fromRgb565(color0, palette[0]);
+            fromRgb565(color1, palette[1]);
+            for(int c = 0; c < 3; ++c)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            for(int i = 0; i < 16; ++i)
+            {
+                int best = 0, bestDistance = 1 << 30;
+                for(int p = 0; p < 4; ++p)
+                {
+                    int distance = 0;
+                    for(int c = 0; c < 3; ++c)
+                        distance += (block.texels[i][c] - palette[p][c]) * (block.texels[i][c] - palette[p][c]);
+                    if (distance < bestDistance)
+                    {
+                        best = p;
+                        bestDistance = distance;
+                    }
+                }
+                indices |= uint32_t(best) << (2 * i);
+            }
+        }
+        const GLubyte encoded[8] = {
+            GLubyte(color0), GLubyte(color0 >> 8), GLubyte(color1), GLubyte(color1 >> 8),
+            GLubyte(indices), GLubyte(indices >> 8), GLubyte(indices >> 16), GLubyte(indices >> 24)
+        };
+        std::memcpy(out, encoded, sizeof(encoded));
+    }
+
+    // BC4 block of one channel, also the alpha of BC3 and each half of BC5
+    void encodeChannelBlock(const Block &block, int channel, GLubyte *out)
+    {
+        int high = 0, low = 255;
+        for(const auto &texel : block.texels)
+        {
+            high = std::max(high, (int)texel[channel]);
+            low = std::min(low, (int)texel[channel]);
+        }
+        uint64_t indices = 0;
+        // high > low selects the eight value mode, equal ones leave every index at 0
+        if (high != low)
+        {
+            int palette[8] = {high, low};
+            for(int p = 1; p < 7; ++p)
+                palette[p + 1] = ((7 - p) * high + p * low) / 7;
+            for(int i = 0; i < 16; ++i)
+            {
+                int best = 0, bestDistance = 256;
+                for(int p = 0; p < 8; ++p)
+                {
+                    const int distance = std::abs(block.texels[i][channel] - palette[p]);
+                    if (distance < bestDistance)
+                    {
+                        best = p;
+                        bestDistance = distance;
+                    }
+                }
+                indices |= uint64_t(best) << (3 * i);
+            }
+        }
+        out[0] = GLubyte(high);
+        out[1] = GLubyte(low);
+        for(int i = 0; i < 6; ++i)
+            out[2 + i] = GLubyte(indices >> (8 * i));
+    }
+
+    void encodeBlock(GLenum format, const Block &block, GLubyte *out)
+    {
+        switch (format)
+        {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+            encodeColorBlock(block, out);
+            break;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+            encodeChannelBlock(block, 3, out);
+            encodeColorBlock(block, out + 8);
+            break;
+        case GL_COMPRESSED_RED_RGTC1:
+            encodeChannelBlock(block, 0, out);
+            break;
+        case GL_COMPRESSED_RG_RGTC2:
+            encodeChannelBlock(block, 0, out);
+            encodeChannelBlock(block, 1, out + 8);
+            break;
+        }
+    }
+}
+
+GLenum TextureCompressor::PickFormat(const TextureImage &image)
+{
+    if (!enabled || image.compressedFormat || image.LevelCount() == 0)
+        return 0;
+    GLenum format = 0;
+    switch (image.channels)
+    {
+    case 1: format = GL_COMPRESSED_RED_RGTC1; break;
+    case 2: format = GL_COMPRESSED_RG_RGTC2; break;
+    case 3: format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT; break;
+    case 4:
+    {
+        // BC1 is half the size when there's nothing to blend
+        const GLubyte *pixels = image.LevelPixels(0);
+        const size_t texels = size_t(image.width) * image.height;
+        format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        for(size_t i = 0; i < texels; ++i)
+        {
+            if (pixels[i * 4 + 3] != 255)
+            {
+                format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+                break;
+            }
+        }
+        break;
+    }
+    }
+    return IsSupported(format) ? format : 0;
+}
+
+bool TextureCompressor::IsSupported(GLenum format)
+{
+    switch (format)
+    {
+    case GL_COMPRESSED_RED_RGTC1:
+    case GL_COMPRESSED_RG_RGTC2:
+        return true;
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        return GLExt::textureCompressionS3TC;
+    default:
+        return false;
+    }
+}
+
+void TextureCompressor::Compress(TextureImage &image, GLenum format)
+{
+    TraceScope trace("texture", "Compress " + image.filename);
+    const int levels = image.LevelCount();
+    const int blockBytes = format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RED_RGTC1 ? 8 : 16;
+    std::vector<size_t> offsets;
+    size_t size = 0;
+    for(int level = 0; level < levels; ++level)
+    {
+        offsets.push_back(size);
+        size += TextureImage::LevelBytes(format, image.channels, image.LevelWidth(level), image.LevelHeight(level));
+    }
+    std::vector<GLubyte> blocks(size);
+
+    for(int level = 0; level < levels; ++level)
+    {
+        const int width = image.LevelWidth(level);
+        const int height = image.LevelHeight(level);
+        const int blocksWide = (width + 3) / 4;
+        const GLubyte *pixels = image.LevelPixels(level);
+        GLubyte *out = blocks.data() + offsets[level];
+        parallelFor((height + 3) / 4, [&](int begin, int end) {
+            for(int blockY = begin; blockY < end; ++blockY)
+                for(int blockX = 0; blockX < blocksWide; ++blockX)
+                    encodeBlock(format, loadBlock(pixels, width, height, image.channels, blockX, blockY),
+                                out + (size_t(blockY) * blocksWide + blockX) * blockBytes);
+        });
+    }
+
+    image.compressedFormat = format;
+    image.pixels = std::move(blocks);
+    image.levelOffsets = std::move(offsets);
+    image.cooked.reset();
+}
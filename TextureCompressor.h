@@ -0,0 +1,20 @@
+#pragma once
+
+#include <glad/glad.h>
+
+struct TextureImage;
+
+// CPU block encoder for cooked textures: BC1 for RGB, BC3 for RGBA with transparency,
+// BC4 and BC5 for one and two channels. Blocks are split across a worker pool.
+class TextureCompressor
+{
+public:
+    static bool enabled;
+
+    // 0 when `image` is better left uncompressed or the GL can't sample the format
+    static GLenum PickFormat(const TextureImage &image);
+    static bool IsSupported(GLenum format);
+
+    // Replaces every level of the plain `image` with `format` blocks
+    static void Compress(TextureImage &image, GLenum format);
+};
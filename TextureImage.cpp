@@ -0,0 +1,138 @@
+#include "TextureImage.h"
+#include "GLExtensions.h"
+#include <cmath>
+
+namespace
+{
+    float srgbToLinear(float c)
+    {
+        return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float linearToSrgb(float c)
+    {
+        return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+    }
+
+    // tables so that a 2048x2048 chain doesn't cost millions of pow calls
+    const int LINEAR_STEPS = 4096;
+
+    struct SrgbTables
+    {
+        float toLinear[256];
+        GLubyte fromLinear[LINEAR_STEPS + 1];
+
+        SrgbTables()
+        {
+            for(int i = 0; i < 256; ++i)
+                toLinear[i] = srgbToLinear(i / 255.f);
+            for(int i = 0; i <= LINEAR_STEPS; ++i)
+                fromLinear[i] = GLubyte(linearToSrgb(float(i) / LINEAR_STEPS) * 255.f + 0.5f);
+        }
+    };
+
+    const SrgbTables &srgbTables()
+    {
+        static const SrgbTables tables;
+        return tables;
+    }
+}
+
+int TextureImage::MipCount(int width, int height)
+{
+    int count = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(width >> 1, 1);
+        height = std::max(height >> 1, 1);
+        ++count;
+    }
+    return count;
+}
+
+GLenum TextureImage::PixelFormat() const
+{
+    switch (channels)
+    {
+    case 1: return GL_RED;
+    case 2: return GL_RG;
+    case 4: return GL_RGBA;
+    default: return GL_RGB;
+    }
+}
+
+size_t TextureImage::GpuBytes() const
+{
+    size_t bytes = 0;
+    for(int level = 0; level < LevelCount(); ++level)
+        bytes += LevelBytes(level);
+    // RGB8 is stored padded to 4 bytes by common drivers
+    if (!compressedFormat && channels == 3)
+        bytes = bytes / 3 * 4;
+    return bytes;
+}
+
+size_t TextureImage::LevelBytes(GLenum compressedFormat, int channels, int width, int height)
+{
+    const size_t blocks = size_t((width + 3) / 4) * ((height + 3) / 4);
+    switch (compressedFormat)
+    {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RED_RGTC1:
+        return blocks * 8;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_RG_RGTC2:
+        return blocks * 16;
+    default:
+        return size_t(width) * height * channels;
+    }
+}
+
+// odd edges reuse their last row or column
+void GenerateMipmaps(TextureImage& image, bool srgb)
+{
+    const int channels = image.channels;
+    const int levels = TextureImage::MipCount(image.width, image.height);
+    image.levelOffsets.resize(1);
+    size_t size = image.LevelBytes(0);
+    for(int level = 1; level < levels; ++level)
+    {
+        image.levelOffsets.push_back(size);
+        size += image.LevelBytes(level);
+    }
+    image.pixels.resize(size);
+
+    const SrgbTables &tables = srgbTables();
+    const int colorChannels = srgb && channels >= 3 ? 3 : 0;
+    for(int level = 1; level < levels; ++level)
+    {
+        const int srcWidth = image.LevelWidth(level - 1);
+        const int srcHeight = image.LevelHeight(level - 1);
+        const int width = image.LevelWidth(level);
+        const int height = image.LevelHeight(level);
+        const GLubyte *src = image.pixels.data() + image.levelOffsets[level - 1];
+        GLubyte *dst = image.pixels.data() + image.levelOffsets[level];
+        for(int y = 0; y < height; ++y)
+        {
+            const int y0 = std::min(2 * y, srcHeight - 1);
+            const int y1 = std::min(2 * y + 1, srcHeight - 1);
+            for(int x = 0; x < width; ++x)
+            {
+                const int x0 = std::min(2 * x, srcWidth - 1);
+                const int x1 = std::min(2 * x + 1, srcWidth - 1);
+                const GLubyte *texels[4] = {
+                    src + (size_t(y0) * srcWidth + x0) * channels, src + (size_t(y0) * srcWidth + x1) * channels,
+                    src + (size_t(y1) * srcWidth + x0) * channels, src + (size_t(y1) * srcWidth + x1) * channels
+                };
+                GLubyte *out = dst + (size_t(y) * width + x) * channels;
+                for(int c = 0; c < colorChannels; ++c)
+                {
+                    const float sum = tables.toLinear[texels[0][c]] + tables.toLinear[texels[1][c]] + tables.toLinear[texels[2][c]] + tables.toLinear[texels[3][c]];
+                    out[c] = tables.fromLinear[int(sum * 0.25f * LINEAR_STEPS + 0.5f)];
+                }
+                for(int c = colorChannels; c < channels; ++c)
+                    out[c] = GLubyte((texels[0][c] + texels[1][c] + texels[2][c] + texels[3][c] + 2) / 4);
+            }
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+// Pixels of a texture file and its whole mip chain, decoded or read from the texture
+// cache on any thread, see DecodeTexture. Levels are either plain 8-bit channels with
+// tightly packed rows or 4x4 blocks of `compressedFormat`.
+struct TextureImage
+{
+    std::string filename; // where the file was found
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    GLenum compressedFormat = 0; // see TextureCompressor, 0 for plain channels
+    std::vector<GLubyte> pixels; // every level back to back, empty when they're in `cooked`
+    std::shared_ptr<const MappedFile> cooked;
+    std::vector<size_t> levelOffsets; // level 0 down to 1x1, into `pixels` or `cooked`, empty if the file couldn't be read
+
+    int LevelCount() const { return (int)levelOffsets.size(); }
+    int LevelWidth(int level) const { return std::max(width >> level, 1); }
+    int LevelHeight(int level) const { return std::max(height >> level, 1); }
+    size_t LevelBytes(int level) const { return LevelBytes(compressedFormat, channels, LevelWidth(level), LevelHeight(level)); }
+    const GLubyte *LevelPixels(int level) const { return (cooked ? cooked->Data() : pixels.data()) + levelOffsets[level]; }
+    // pixel rows for plain levels, rows of 4x4 blocks for compressed ones
+    int RowHeight() const { return compressedFormat ? 4 : 1; }
+    // GL format of plain levels, also used as their internal format
+    GLenum PixelFormat() const;
+    // what the driver likely allocates for the whole chain, for MemoryTracker
+    size_t GpuBytes() const;
+
+    static int MipCount(int width, int height);
+    static size_t LevelBytes(GLenum compressedFormat, int channels, int width, int height);
+};
+
+// Lays out the mip chain after level 0 in `pixels` and fills it with a 2x2 box filter.
+// `srgb` averages the color channels in linear space, alpha is always linear.
+void GenerateMipmaps(TextureImage& image, bool srgb);
@@ -0,0 +1,193 @@
+#include "TextureStreamer.h"
+#include "AssetRegistry.h"
+#include "GLState.h"
+#include "MemoryTracker.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <iostream>
+
+size_t TextureStreamer::budgetBytesPerFrame = 4 << 20;
+
+namespace
+{
+    const int PIXEL_BUFFER_COUNT = 3;
+
+    struct PixelBuffer
+    {
+        GLuint buffer = 0;
+        GLsizeiptr capacity = 0;
+        GLsync fence = 0;
+    };
+
+    struct Upload
+    {
+        GLuint texture;
+        std::shared_ptr<const TextureImage> image;
+        int level; // being uploaded, goes down to 0
+        int row;   // next row of that level, see TextureImage::RowHeight
+    };
+
+    PixelBuffer pixelBuffers[PIXEL_BUFFER_COUNT];
+    int nextPixelBuffer = 0;
+    std::deque<Upload> uploads;
+    size_t uploadedLastFrame = 0;
+
+    int levelRows(const TextureImage &image, int level)
+    {
+        return (image.LevelHeight(level) + image.RowHeight() - 1) / image.RowHeight();
+    }
+
+    void defineLevel(const TextureImage &image, int level, const void *pixels)
+    {
+        const int width = image.LevelWidth(level);
+        const int height = image.LevelHeight(level);
+        if (image.compressedFormat)
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, image.compressedFormat, width, height, 0, (GLsizei)image.LevelBytes(level), pixels);
+        else
+            glTexImage2D(GL_TEXTURE_2D, level, image.PixelFormat(), width, height, 0, image.PixelFormat(), GL_UNSIGNED_BYTE, pixels);
+    }
+
+    // false while the GPU may still read the buffer
+    bool acquire(PixelBuffer &pixelBuffer)
+    {
+        if (!pixelBuffer.fence)
+            return true;
+        GLenum status = glClientWaitSync(pixelBuffer.fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED)
+            return false;
+        if (status == GL_WAIT_FAILED)
+            std::cerr << "ERROR::TEXTURE_STREAMER::WAIT_FAILED" << std::endl;
+        glDeleteSync(pixelBuffer.fence);
+        pixelBuffer.fence = 0;
+        return true;
+    }
+
+    void reserve(PixelBuffer &pixelBuffer, GLsizeiptr bytes)
+    {
+        if (!pixelBuffer.buffer)
+            glGenBuffers(1, &pixelBuffer.buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer.buffer);
+        if (pixelBuffer.capacity >= bytes)
+            return;
+        if (pixelBuffer.capacity)
+            MemoryTracker::Untrack(MEMORY_TEXTURES, MEMORY_OBJECT_BUFFER, pixelBuffer.buffer);
+        pixelBuffer.capacity = bytes;
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+        MemoryTracker::Track(MEMORY_TEXTURES, MEMORY_OBJECT_BUFFER, pixelBuffer.buffer, "streaming pixel buffer", bytes);
+    }
+}
+
+GLuint TextureStreamer::Create(std::shared_ptr<const TextureImage> image, GLuint texture/* = 0*/)
+{
+    GLuint textureID = texture;
+    if (textureID)
+        Cancel(textureID);
+    else
+        glGenTextures(1, &textureID);
+    if (!image || image->LevelCount() == 0)
+        return textureID;
+
+    const int levels = image->LevelCount();
+    GLState::BindTexture(GL_TEXTURE_2D, textureID);
+    // every level is defined up front, sampling is limited to the uploaded ones
+    for(int level = 0; level < levels - 1; ++level)
+        defineLevel(*image, level, NULL);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    defineLevel(*image, levels - 1, image->LevelPixels(levels - 1));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    MemoryTracker::Track(MEMORY_TEXTURES, MEMORY_OBJECT_TEXTURE, textureID, image->filename, image->GpuBytes());
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    if (levels > 1)
+        uploads.push_back({textureID, std::move(image), levels - 2, 0});
+    return textureID;
+}
+
+void TextureStreamer::Cancel(GLuint texture)
+{
+    uploads.erase(std::remove_if(uploads.begin(), uploads.end(), [texture](const Upload &upload) { return upload.texture == texture; }), uploads.end());
+}
+
+void TextureStreamer::Update()
+{
+    uploadedLastFrame = 0;
+    if (uploads.empty())
+        return;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    while (!uploads.empty() && (uploadedLastFrame < budgetBytesPerFrame || uploadedLastFrame == 0))
+    {
+        PixelBuffer &pixelBuffer = pixelBuffers[nextPixelBuffer];
+        if (!acquire(pixelBuffer))
+            break;
+
+        Upload &upload = uploads.front();
+        const TextureImage &image = *upload.image;
+        const int width = image.LevelWidth(upload.level);
+        const int height = image.LevelHeight(upload.level);
+        const int levelRowCount = levelRows(image, upload.level);
+        const size_t rowBytes = image.LevelBytes(upload.level) / levelRowCount;
+        const size_t budgetLeft = budgetBytesPerFrame > uploadedLastFrame ? budgetBytesPerFrame - uploadedLastFrame : 0;
+        const int rows = std::min(levelRowCount - upload.row, std::max(int(budgetLeft / rowBytes), 1));
+        const size_t bytes = rows * rowBytes;
+
+        reserve(pixelBuffer, GLsizeiptr(bytes));
+        void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, GLsizeiptr(bytes), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!mapped)
+        {
+            std::cerr << "ERROR::TEXTURE_STREAMER::MAP_FAILED" << std::endl;
+            break;
+        }
+        std::memcpy(mapped, image.LevelPixels(upload.level) + upload.row * rowBytes, bytes);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        GLState::BindTexture(GL_TEXTURE_2D, upload.texture);
+        const int y = upload.row * image.RowHeight();
+        const int subHeight = std::min(rows * image.RowHeight(), height - y);
+        if (image.compressedFormat)
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, upload.level, 0, y, width, subHeight, image.compressedFormat, (GLsizei)bytes, NULL);
+        else
+            glTexSubImage2D(GL_TEXTURE_2D, upload.level, 0, y, width, subHeight, image.PixelFormat(), GL_UNSIGNED_BYTE, NULL);
+        pixelBuffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        nextPixelBuffer = (nextPixelBuffer + 1) % PIXEL_BUFFER_COUNT;
+        uploadedLastFrame += bytes;
+
+        upload.row += rows;
+        if (upload.row < levelRowCount)
+            continue;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, upload.level);
+        // the next level waits behind the other textures' current ones
+        Upload next = std::move(upload);
+        uploads.pop_front();
+        if (--next.level >= 0)
+        {
+            next.row = 0;
+            uploads.push_back(std::move(next));
+        }
+    }
+    // client memory pointers would be read as buffer offsets otherwise
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+TextureStreamerStats TextureStreamer::Stats()
+{
+    TextureStreamerStats stats;
+    stats.pendingTextures = uploads.size();
+    stats.uploadedLastFrame = uploadedLastFrame;
+    for(const Upload &upload : uploads)
+    {
+        const TextureImage &image = *upload.image;
+        stats.pendingBytes += image.LevelBytes(upload.level) - upload.row * (image.LevelBytes(upload.level) / levelRows(image, upload.level));
+        for(int level = 0; level < upload.level; ++level)
+            stats.pendingBytes += image.LevelBytes(level);
+    }
+    return stats;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <memory>
+
+struct TextureImage;
+
+struct TextureStreamerStats
+{
+    size_t pendingTextures = 0;
+    size_t pendingBytes = 0;
+    size_t uploadedLastFrame = 0;
+};
+
+// Uploads textures over several frames through a ring of pixel buffer objects.
+// A new texture samples its 1x1 mip right away, then the larger levels come in
+// smallest first, all textures advancing a level at a time. A buffer is only
+// refilled once the fence of its last upload has signaled, so the CPU never waits.
+class TextureStreamer
+{
+public:
+    // bytes copied to pixel buffers per Update, always at least one row
+    static size_t budgetBytesPerFrame;
+
+    // GL thread. Allocates the whole mip chain of `image` and uploads its 1x1 level,
+    // the image is kept alive until the rest streamed in. A nonzero `texture` is
+    // respecified in place, its pending levels dropped, instead of generating a new one.
+    static GLuint Create(std::shared_ptr<const TextureImage> image, GLuint texture = 0);
+    // Drops the pending levels of `texture`, call before deleting it
+    static void Cancel(GLuint texture);
+
+    // GL thread, once per frame
+    static void Update();
+    static TextureStreamerStats Stats();
+};
@@ -0,0 +1,50 @@
+#include "ThreadPool.h"
+#include "Trace.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threadCount/* = 0*/)
+{
+    if (threadCount == 0)
+        threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    for(unsigned i = 0; i < threadCount; ++i)
+        workers.emplace_back(&ThreadPool::run, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        tasks.clear();
+    }
+    wakeUp.notify_all();
+    for(std::thread& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    wakeUp.notify_one();
+}
+
+void ThreadPool::run()
+{
+    Trace::SetThreadName("worker");
+    for(;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (stopping)
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,165 @@
+#include "Trace.h"
+#include "FileUtils.h"
+#include "json.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+bool Trace::enabled = true;
+
+namespace
+{
+    const size_t CHUNK_EVENTS = 512;
+    const size_t MAX_CHUNKS = 256; // per thread, later events are dropped
+
+    struct Event
+    {
+        const char *category = nullptr;
+        std::string name;
+        double begin = 0.0;
+        double duration = -1.0; // instants have none
+    };
+
+    // Written by its thread only. Chunks never move once published, so Write can read
+    // every event below `count` while the thread keeps appending.
+    struct ThreadBuffer
+    {
+        int id = 0;
+        std::string name; // under registryMutex
+        std::atomic<Event*> chunks[MAX_CHUNKS] = {};
+        std::atomic<size_t> count{0};
+        std::atomic<size_t> dropped{0};
+
+        ~ThreadBuffer()
+        {
+            for(auto &chunk : chunks)
+                delete[] chunk.load();
+        }
+    };
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers; // outlive their threads
+    thread_local ThreadBuffer *threadBuffer = nullptr;
+
+    ThreadBuffer &currentBuffer()
+    {
+        if (!threadBuffer)
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            buffers.push_back(std::make_unique<ThreadBuffer>());
+            threadBuffer = buffers.back().get();
+            threadBuffer->id = (int)buffers.size();
+        }
+        return *threadBuffer;
+    }
+
+    void append(const char *category, const std::string &name, double begin, double duration)
+    {
+        ThreadBuffer &buffer = currentBuffer();
+        const size_t index = buffer.count.load(std::memory_order_relaxed);
+        const size_t chunk = index / CHUNK_EVENTS;
+        if (chunk >= MAX_CHUNKS)
+        {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Event *events = buffer.chunks[chunk].load(std::memory_order_relaxed);
+        if (!events)
+        {
+            events = new Event[CHUNK_EVENTS];
+            buffer.chunks[chunk].store(events, std::memory_order_release);
+        }
+        Event &event = events[index % CHUNK_EVENTS];
+        event.category = category;
+        event.name = name;
+        event.begin = begin;
+        event.duration = duration;
+        // publishes the event to Write
+        buffer.count.store(index + 1, std::memory_order_release);
+    }
+}
+
+double Trace::Now()
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void Trace::Record(const char *category, const std::string &name, double begin, double end)
+{
+    if (enabled)
+        append(category, name, begin, end - begin);
+}
+
+void Trace::Instant(const char *category, const std::string &name)
+{
+    if (enabled)
+        append(category, name, Now(), -1.0);
+}
+
+void Trace::SetThreadName(const std::string &name)
+{
+    ThreadBuffer &buffer = currentBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer.name = name;
+}
+
+bool Trace::Write(const std::string &path)
+{
+    using json = nlohmann::json;
+    json events = json::array();
+    size_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for(const auto &buffer : buffers)
+        {
+            if (!buffer->name.empty())
+                events.push_back({{"ph", "M"}, {"name", "thread_name"}, {"pid", 1}, {"tid", buffer->id}, {"args", {{"name", buffer->name}}}});
+
+            const size_t count = buffer->count.load(std::memory_order_acquire);
+            for(size_t i = 0; i < count; ++i)
+            {
+                const Event &event = buffer->chunks[i / CHUNK_EVENTS].load(std::memory_order_acquire)[i % CHUNK_EVENTS];
+                json jEvent = {{"name", event.name}, {"cat", event.category}, {"ts", event.begin}, {"pid", 1}, {"tid", buffer->id}};
+                if (event.duration < 0.0)
+                {
+                    jEvent["ph"] = "i";
+                    jEvent["s"] = "g";
+                }
+                else
+                {
+                    jEvent["ph"] = "X";
+                    jEvent["dur"] = event.duration;
+                }
+                events.push_back(std::move(jEvent));
+            }
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+        }
+    }
+    if (dropped)
+        std::cerr << "ERROR::TRACE::EVENTS_DROPPED " << dropped << std::endl;
+
+    const std::string text = json{{"traceEvents", std::move(events)}, {"displayTimeUnit", "ms"}}.dump();
+    if (!WriteFile(path, text.data(), text.size()))
+    {
+        std::cerr << "ERROR::TRACE::WRITE_FAILED " << path << std::endl;
+        return false;
+    }
+    std::cout << "Trace written to " << path << std::endl;
+    return true;
+}
+
+TraceScope::TraceScope(const char *category_, std::string name_)
+    : category(category_), name(std::move(name_)), begin(Trace::enabled ? Trace::Now() : 0.0)
+{
+}
+
+TraceScope::~TraceScope()
+{
+    if (Trace::enabled)
+        Trace::Record(category, name, begin, Trace::Now());
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+
+// Timeline of scoped events, written as Chrome trace JSON for chrome://tracing or
+// ui.perfetto.dev. Each thread appends to its own buffer without locking, the buffer
+// is registered once on the thread's first event and kept until exit.
+class Trace
+{
+public:
+    // checked on every event, scopes cost a branch and their name when off
+    static bool enabled;
+
+    // Shown instead of the thread id in the viewer
+    static void SetThreadName(const std::string &name);
+    // Zero-length marker, e.g. when the scene finished loading
+    static void Instant(const char *category, const std::string &name);
+    // Any thread. Events still being recorded by other threads may be left out.
+    static bool Write(const std::string &path);
+
+    // microseconds since the start of the program
+    static double Now();
+    static void Record(const char *category, const std::string &name, double begin, double end);
+};
+
+// Records the time from its construction to its destruction. `category` must be a literal.
+class TraceScope
+{
+public:
+    TraceScope(const char *category, std::string name);
+    ~TraceScope();
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char *category;
+    std::string name;
+    double begin;
+};
@@ -0,0 +1,36 @@
+#include "UniformBuffer.h"
+#include "MemoryTracker.h"
+#include <cstring>
+
+GLuint UniformBlockBinding(const char *blockName)
+{
+    if (std::strcmp(blockName, "FrameData") == 0)
+        return FRAME_DATA_BINDING;
+    if (std::strcmp(blockName, "Lights") == 0)
+        return LIGHTS_BINDING;
+    return INVALID_BLOCK_BINDING;
+}
+
+UniformBuffer::UniformBuffer(GLuint binding_, GLsizeiptr size_)
+    : binding(binding_)
+    , size(size_)
+{
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, ubo);
+    MemoryTracker::Track(MEMORY_UNIFORM_BUFFERS, MEMORY_OBJECT_BUFFER, ubo, "binding " + std::to_string(binding), size);
+}
+
+void UniformBuffer::Upload(const void *data, GLsizeiptr dataSize, GLintptr offset/* = 0*/)
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    // a full rewrite orphans the old storage so we don't wait for draws still reading it
+    if (offset == 0 && dataSize == size)
+        glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW);
+    else
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, dataSize, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+
+// Fixed binding points shared by every program, see Shader::bindUniformBlocks
+enum : GLuint
+{
+    FRAME_DATA_BINDING = 0,
+    LIGHTS_BINDING = 1,
+    INVALID_BLOCK_BINDING = ~0u
+};
+
+GLuint UniformBlockBinding(const char *blockName);
+
+// C++ mirrors of std140 blocks check their layout at compile time with this
+#define CHECK_STD140_OFFSET(type, member, offset) \
+    static_assert(offsetof(type, member) == (offset), #type "::" #member " doesn't match the std140 layout")
+
+class UniformBuffer
+{
+    GLuint ubo;
+    GLuint binding;
+    GLsizeiptr size;
+
+public:
+    UniformBuffer(GLuint binding, GLsizeiptr size);
+
+    void Upload(const void *data, GLsizeiptr dataSize, GLintptr offset = 0);
+
+    template<typename T>
+    void Upload(const T &data)
+    {
+        static_assert(sizeof(T) % 16 == 0, "std140 block size must be a multiple of vec4");
+        Upload(&data, sizeof(T));
+    }
+};
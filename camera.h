@@ -1,58 +1,58 @@
-#ifndef CAMERA_H
-#define CAMERA_H
-
-#include <glad/glad.h>
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-
-#include <vector>
-
-enum Camera_Movement
-{
-    FORWARD,
-    BACKWARD,
-    LEFT,
-    RIGHT,
-    UP,
-    DOWN
-};
-
-const float YAW = -90.0f;
-const float PITCH = 0.0f;
-const float SPEED = 4.f;
-const float SENSITIVTY = 0.3f;
-const float ZOOM = 45.0f;
-
-class Camera
-{
-  public:
-    glm::vec3 Position;
-    glm::vec3 Front;
-    glm::vec3 Up;
-    glm::vec3 Right;
-    glm::vec3 WorldUp;
-    float Yaw;
-    float Pitch;
-    float MovementSpeed;
-    float MouseSensitivity;
-    float Zoom;
-
-    Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH);
-    Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch);
-
-    glm::mat4 GetViewMatrix();
-
-    void SetPosition(const glm::vec3 position);
-
-    void ProcessKeyboard(Camera_Movement direction, float deltaTime);
-
-    void ProcessMouseMovement(float xoffset, float yoffset, GLboolean constrainPitch = true);
-
-    void ProcessMouseScroll(float yoffset);
-
-    void ResetZoom() { Zoom = ZOOM; }
-
-  private:
-    void updateCameraVectors();
-};
-#endif
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+
+enum Camera_Movement
+{
+    FORWARD,
+    BACKWARD,
+    LEFT,
+    RIGHT,
+    UP,
+    DOWN
+};
+
+const float YAW = -90.0f;
+const float PITCH = 0.0f;
+const float SPEED = 4.f;
+const float SENSITIVTY = 0.3f;
+const float ZOOM = 45.0f;
+
+class Camera
+{
+  public:
+    glm::vec3 Position;
+    glm::vec3 Front;
+    glm::vec3 Up;
+    glm::vec3 Right;
+    glm::vec3 WorldUp;
+    float Yaw;
+    float Pitch;
+    float MovementSpeed;
+    float MouseSensitivity;
+    float Zoom;
+
+    Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH);
+    Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch);
+
+    glm::mat4 GetViewMatrix();
+
+    void SetPosition(const glm::vec3 position);
+
+    void ProcessKeyboard(Camera_Movement direction, float deltaTime);
+
+    void ProcessMouseMovement(float xoffset, float yoffset, GLboolean constrainPitch = true);
+
+    void ProcessMouseScroll(float yoffset);
+
+    void ResetZoom() { Zoom = ZOOM; }
+
+  private:
+    void updateCameraVectors();
+};
+#endif
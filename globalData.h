@@ -1,89 +1,109 @@
-#pragma once
-
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
-#include <glm/glm.hpp>
-#include "camera.h"
-#include "ShadersManager.h"
-
-inline void glSet(GLenum prop, bool value)
-{
-    if (value)
-        glEnable(prop);
-    else
-        glDisable(prop);
-}
-
-struct Light {
-    int type; // 0 - point light, 1 - direction light, 2 - spotlight
-    glm::vec3 ambient{0.1f, 0.1f, 0.1f};
-    glm::vec3 diffuse{1.0f, 1.0f, 1.0f};
-    glm::vec3 specular{1.0f, 1.0f, 1.0f};
-
-    // for point light (http://wiki.ogre3d.org/tiki-index.php?page=-Point+Light+Attenuation)
-    float constant{1.f}, linear{0.09f}, quadratic{0.032f};
-    
-    // only for point and spot light
-    glm::vec3 location{0.f, 0.f, 0.f};
-    
-    // only for spot and direction light
-    glm::vec3 direction{-0.5f, -1.f, -0.3f};
-    
-    //only for spotlight
-    float innerCutOff{0.97629600712f}; // cos(12.5)
-    float outerCutOff{0.95371695074f}; // cos(17.5)
-
-    Light(int type_ = 0) : type(type_) {
-        if (type == 2)
-        {
-            diffuse = {0.5f, 0.5f, 0.5f};
-            specular = {0.5f, 0.5f, 0.5f};
-        }
-    }
-};
-
-class GlobalData
-{
-public:
-    static GlobalData& GetInstance()
-    {
-        static GlobalData obj;
-        return obj;
-    }
-    
-    GLenum mode = GL_FILL;
-    std::vector<Light> lights;
-    bool drawLight = true;
-    Camera camera;
-
-    float width = 1280.f;
-    float height = 720.f;
-
-    // cursor processing
-    bool cursorCaptured = false;
-    double lastX, lastY;
-
-    bool faceCulling = false;
-    int postEffect = 0;
-
-    static const glm::vec3 DEFAULT_CAMERA_POS;
-    
-    bool evening = false;
-
-    // post-processing
-    int SCREEN_SHADER_ID = 0;
-    int currentScreenShader = 0;
-    int currentKernel = 0;
-
-    ShadersManager shadersManager;
-    std::vector<class Model*> models;
-    std::vector<class Model*> unsortedModels;
-
-private:
-    GlobalData()
-        : camera(DEFAULT_CAMERA_POS)
-    {
-    }
-};
-
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include "camera.h"
+#include "ShadersManager.h"
+#include "GLState.h"
+#include "LightBuffer.h"
+#include <algorithm>
+
+inline void glSet(GLenum prop, bool value)
+{
+    GLState::Set(prop, value);
+}
+
+struct Light {
+    int type; // 0 - point light, 1 - direction light, 2 - spotlight
+    glm::vec3 ambient{0.1f, 0.1f, 0.1f};
+    glm::vec3 diffuse{1.0f, 1.0f, 1.0f};
+    glm::vec3 specular{1.0f, 1.0f, 1.0f};
+
+    // for point light (http://wiki.ogre3d.org/tiki-index.php?page=-Point+Light+Attenuation)
+    float constant{1.f}, linear{0.09f}, quadratic{0.032f};
+    
+    // only for point and spot light
+    glm::vec3 location{0.f, 0.f, 0.f};
+    
+    // only for spot and direction light
+    glm::vec3 direction{-0.5f, -1.f, -0.3f};
+    
+    //only for spotlight
+    float innerCutOff{0.97629600712f}; // cos(12.5)
+    float outerCutOff{0.95371695074f}; // cos(17.5)
+
+    Light(int type_ = 0) : type(type_) {
+        if (type == 2)
+        {
+            diffuse = {0.5f, 0.5f, 0.5f};
+            specular = {0.5f, 0.5f, 0.5f};
+        }
+    }
+};
+
+class GlobalData
+{
+public:
+    static GlobalData& GetInstance()
+    {
+        static GlobalData obj;
+        return obj;
+    }
+    
+    GLenum mode = GL_FILL;
+    std::vector<Light> lights;
+    // bump after editing lights so LightBuffer re-uploads them
+    unsigned lightsVersion = 0;
+    // lights of each type the GPU sees, specialized shaders are compiled for these counts
+    int dirLightsCount = 0;
+    int pointLightsCount = 0;
+    int spotLightsCount = 0;
+
+    void LightsChanged()
+    {
+        ++lightsVersion;
+        int counts[3] = {0, 0, 0};
+        for (const Light& light : lights)
+            if (light.type >= 0 && light.type < 3)
+                ++counts[light.type];
+        pointLightsCount = std::min(counts[0], MAX_POINT_LIGHTS);
+        dirLightsCount = std::min(counts[1], MAX_DIR_LIGHTS);
+        spotLightsCount = std::min(counts[2], MAX_SPOT_LIGHTS);
+    }
+    bool drawLight = true;
+    Camera camera;
+
+    float width = 1280.f;
+    float height = 720.f;
+
+    // cursor processing
+    bool cursorCaptured = false;
+    double lastX, lastY;
+
+    bool faceCulling = false;
+    int postEffect = 0;
+
+    static const glm::vec3 DEFAULT_CAMERA_POS;
+    
+    bool evening = false;
+
+    // post-processing
+    int SCREEN_SHADER_ID = 0;
+    int currentScreenShader = 0;
+    int currentKernel = 0;
+
+    ShadersManager shadersManager;
+    size_t pendingModels = 0; // imports SceneLoader hasn't uploaded yet
+    std::vector<class Model*> models;
+    std::vector<class Model*> unsortedModels;
+    class QuadBatcher *quadBatcher = nullptr; // textured quads of the scene, owned by main
+
+private:
+    GlobalData()
+        : camera(DEFAULT_CAMERA_POS)
+    {
+    }
+};
+
 #define DATA GlobalData::GetInstance()
\ No newline at end of file
@@ -1,733 +1,873 @@
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
-#include <iostream>
-#include <cmath>
-#include <array>
-
-#include "imgui.h"
-#include "imgui_impl_glfw.h"
-#include "imgui_impl_opengl3.h"
-
-#include "shader.h"
-#include "ShadersManager.h"
-#include "stb_image.h"
-#include "model.h"
-#include "Framebuffer.h"
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-
-#include "json.hpp"
-
-using json = nlohmann::json;
-
-#include "globalData.h"
-const glm::vec3 GlobalData::DEFAULT_CAMERA_POS{0.f, 1.5f, 3.f};
-
-void processInput(GLFWwindow *window, float dt);
-void mouse_callback(GLFWwindow *window, double x, double y);
-void mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
-void scroll_callback(GLFWwindow *window, double dx, double dy);
-GLuint loadTexture(const char *path);
-void SortModelsByDepth();
-
-void SetLights();
-void DrawGUI();
-void LoadSceneFromJSON();
-
-glm::vec3 getVec3(const std::vector<float> vec)
-{
-	return {vec[0], vec[1], vec[2]};
-}
-
-void error_callback(int error, const char *description)
-{
-	std::cerr << "Error: " << description << std::endl;
-}
-
-void framebuffer_size_callback(GLFWwindow *wnd, int width, int height)
-{
-	glViewport(0, 0, width, height);
-	DATA.width = (float)width;
-	DATA.height = (float)height;
-}
-
-void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods)
-{
-	if (ImGui::GetIO().WantCaptureKeyboard)
-		return;
-
-	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
-		glfwSetWindowShouldClose(window, GLFW_TRUE);
-	if (key == GLFW_KEY_ENTER && action == GLFW_PRESS)
-	{
-		if (DATA.mode == GL_LINE)
-			DATA.mode = GL_FILL;
-		else
-			DATA.mode = GL_LINE;
-		glPolygonMode(GL_FRONT_AND_BACK, DATA.mode);
-	}
-	if (key == GLFW_KEY_BACKSPACE && action == GLFW_PRESS)
-		DATA.camera.Position = GlobalData::DEFAULT_CAMERA_POS;
-	if (key == GLFW_KEY_TAB && action == GLFW_PRESS)
-		DATA.drawLight = !DATA.drawLight;
-}
-
-int main(int argc, char **argv)
-{
-	GLFWwindow *wnd;
-
-	if (!glfwInit())
-		return -1;
-
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-	// global callbacks
-	glfwSetErrorCallback(error_callback);
-
-	wnd = glfwCreateWindow((int)DATA.width, (int)DATA.height, "Yo, GLFW!", NULL, NULL);
-	if (!wnd)
-	{
-		glfwTerminate();
-		return -1;
-	}
-
-	// window callbacks
-	glfwSetKeyCallback(wnd, key_callback);
-	glfwSetFramebufferSizeCallback(wnd, framebuffer_size_callback);
-	glfwSetCursorPosCallback(wnd, mouse_callback);
-	glfwSetScrollCallback(wnd, scroll_callback);
-	glfwSetMouseButtonCallback(wnd, mouse_button_callback);
-
-	glfwSetInputMode(wnd, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-
-	glfwMakeContextCurrent(wnd);
-
-	if (glfwRawMouseMotionSupported())
-		glfwSetInputMode(wnd, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
-
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-	{
-		std::cerr << "Failed to initialize GLAD" << std::endl;
-		return -1;
-	}
-
-	ShadersManager &shadersManager = DATA.shadersManager;
-
-	glViewport(0, 0, (GLsizei)DATA.width, (GLsizei)DATA.height);
-	glEnable(GL_BLEND);
-	glSet(GL_CULL_FACE, DATA.faceCulling);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glStencilOp(GL_REPLACE, GL_REPLACE, GL_REPLACE);
-	glDepthFunc(GL_LEQUAL);
-
-	Framebuffer frameBuffer((GLsizei)DATA.width, (GLsizei)DATA.height, {0.1f, 0.1f, 0.1f, 1.0f});
-
-	IMGUI_CHECKVERSION();
-	ImGui::CreateContext();
-	ImGuiIO &io = ImGui::GetIO();
-
-	ImGui::StyleColorsDark();
-	ImGui_ImplGlfw_InitForOpenGL(wnd, true);
-	ImGui_ImplOpenGL3_Init("#version 330 core");
-
-	int modelShaderID = shadersManager.CreateShader("shaders/vertex.glsl", "shaders/fragment.glsl");
-	int lightShaderID = shadersManager.CreateShader("shaders/vertex_lamp.glsl", "shaders/fragment_lamp.glsl");
-	int solidShaderID = shadersManager.CreateShader("shaders/vertex_solid.glsl", "shaders/fragment_solid.glsl");
-	int textureShaderID = shadersManager.CreateShader("shaders/vertex_2D.glsl", "shaders/fragment_model.glsl");
-
-	// screen shaders
-	int screenShaderID = shadersManager.CreateShader("shaders/vertex_quad.glsl", "shaders/fragment_quad.glsl");
-	DATA.SCREEN_SHADER_ID = screenShaderID;
-	DATA.currentScreenShader = screenShaderID;
-	int inverseShaderID = shadersManager.CreateShader("shaders/vertex_quad.glsl", "shaders/fragment_quad_inverse.glsl");
-	int grayscaleShaderID = shadersManager.CreateShader("shaders/vertex_quad.glsl", "shaders/fragment_quad_grayscale.glsl");
-	int kernelShaderID = shadersManager.CreateShader("shaders/vertex_quad.glsl", "shaders/fragment_quad_kernel.glsl");
-
-	int skyboxShaderID = shadersManager.CreateShader("shaders/vertex_skybox.glsl", "shaders/fragment_skybox.glsl");
-
-	Model spotLightModel("shapes/cone.nff", lightShaderID);
-	Model pointLightModel("shapes/sphere.nff", lightShaderID);
-
-	std::vector<std::string> faces{
-		"textures/skybox/right.jpg",
-		"textures/skybox/left.jpg",
-		"textures/skybox/top.jpg",
-		"textures/skybox/bottom.jpg",
-		"textures/skybox/front.jpg",
-		"textures/skybox/back.jpg"};
-	GLuint cubemapTexture = CubemapFromFile(faces);
-	std::array<float, 108> skyboxVertices = {
-		-1.0f, 1.0f, -1.0f,
-		-1.0f, -1.0f, -1.0f,
-		1.0f, -1.0f, -1.0f,
-		1.0f, -1.0f, -1.0f,
-		1.0f, 1.0f, -1.0f,
-		-1.0f, 1.0f, -1.0f,
-
-		-1.0f, -1.0f, 1.0f,
-		-1.0f, -1.0f, -1.0f,
-		-1.0f, 1.0f, -1.0f,
-		-1.0f, 1.0f, -1.0f,
-		-1.0f, 1.0f, 1.0f,
-		-1.0f, -1.0f, 1.0f,
-
-		1.0f, -1.0f, -1.0f,
-		1.0f, -1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, -1.0f,
-		1.0f, -1.0f, -1.0f,
-
-		-1.0f, -1.0f, 1.0f,
-		-1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, -1.0f, 1.0f,
-		-1.0f, -1.0f, 1.0f,
-
-		-1.0f, 1.0f, -1.0f,
-		1.0f, 1.0f, -1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		-1.0f, 1.0f, 1.0f,
-		-1.0f, 1.0f, -1.0f,
-
-		-1.0f, -1.0f, -1.0f,
-		-1.0f, -1.0f, 1.0f,
-		1.0f, -1.0f, -1.0f,
-		1.0f, -1.0f, -1.0f,
-		-1.0f, -1.0f, 1.0f,
-		1.0f, -1.0f, 1.0f};
-	
-	GLuint skyboxVAO, skyboxVBO;
-	glGenVertexArrays(1, &skyboxVAO);
-	glGenBuffers(1,&skyboxVBO);
-	glBindVertexArray(skyboxVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
-	glBufferData(GL_ARRAY_BUFFER, skyboxVertices.size() * sizeof(float), &skyboxVertices[0], GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glBindVertexArray(0);	
-
-	// Scene description >>>
-	LoadSceneFromJSON();
-	for (Model *model : DATA.models)
-		DATA.unsortedModels.push_back(model);
-	// Scene description <<<
-
-	float dt = 0.f;
-	float lastFrame = 0.f;
-	while (!glfwWindowShouldClose(wnd))
-	{
-		float currentFrame = (float)glfwGetTime();
-		dt = currentFrame - lastFrame;
-		lastFrame = currentFrame;
-		processInput(wnd, dt);
-
-		glEnable(GL_DEPTH_TEST);
-		glEnable(GL_STENCIL_TEST);
-		frameBuffer.Use();
-
-		SetLights();
-
-		glm::mat4 view = DATA.camera.GetViewMatrix();
-		glm::mat4 projection = glm::perspective(glm::radians(DATA.camera.Zoom), DATA.width / DATA.height, 0.1f, 100.f);
-		shadersManager.set("view", view);
-		shadersManager.set("projection", projection);
-		shadersManager.set("viewPos", DATA.camera.Position);
-
-		SortModelsByDepth();
-
-		for (Model *model : DATA.models)
-		{
-			if (model->outline)
-			{
-				glStencilFunc(GL_ALWAYS, 1, 0xFF);
-				glStencilMask(0xFF);
-			}
-			else
-			{
-				glStencilMask(0x00);
-			}
-			model->DrawModel();
-		}
-
-		for (Light &light : DATA.lights)
-		{
-			if (light.type == 0)
-			{
-				pointLightModel.SetLocation(light.location);
-				pointLightModel.color = glm::vec4{light.diffuse, 1.f};
-				pointLightModel.SetScale({0.1f, 0.1f, 0.1f});
-				pointLightModel.DrawPointLight();
-			}
-			else if (light.type == 2)
-			{
-				spotLightModel.color = glm::vec4{light.diffuse, 1.f};
-				spotLightModel.SetScale({0.2f, 0.2f, 0.2f});
-				spotLightModel.SetLocation(light.location);
-
-				static const glm::vec3 up{0.f, 1.f, 0.f};
-				glm::vec3 axis = glm::cross(up, glm::normalize(light.direction));
-				float angle = glm::acos(glm::dot(up, glm::normalize(light.direction)));
-				spotLightModel.DrawSpotLight(angle, axis);
-			}
-		}
-		
-		glDepthMask(GL_FALSE);
-		shadersManager.GetShader(skyboxShaderID).use();
-		view = glm::mat4(glm::mat3(view));
-		shadersManager.GetShader(skyboxShaderID).set("view", view);
-		glBindVertexArray(skyboxVAO);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glDepthMask(GL_TRUE);
-
-		for (Model *model : DATA.models)
-		{
-			if (!model->outline)
-				continue;
-
-			// render outline >>>
-			glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
-			glStencilMask(0x00);
-			glDisable(GL_DEPTH_TEST);
-
-			auto tmpShader = model->shaderID;
-			model->shaderID = solidShaderID;
-
-			model->DrawModel();
-
-			model->shaderID = tmpShader;
-
-			glStencilFunc(GL_ALWAYS, 1, 0xFF);
-			glStencilMask(0xFF);
-			glEnable(GL_DEPTH_TEST);
-			// render outline <<<
-		}
-
-		shadersManager.GetShader(DATA.currentScreenShader).use();
-		frameBuffer.Draw();
-
-		DrawGUI();
-
-		glfwSwapBuffers(wnd);
-		glfwPollEvents();
-	}
-
-	glfwTerminate();
-	return 0;
-}
-
-void processInput(GLFWwindow *window, float dt)
-{
-	if (ImGui::GetIO().WantCaptureKeyboard)
-		return;
-
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-		DATA.camera.ProcessKeyboard(Camera_Movement::FORWARD, dt);
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-		DATA.camera.ProcessKeyboard(Camera_Movement::BACKWARD, dt);
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-		DATA.camera.ProcessKeyboard(Camera_Movement::LEFT, dt);
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-		DATA.camera.ProcessKeyboard(Camera_Movement::RIGHT, dt);
-	if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
-		DATA.camera.ProcessKeyboard(Camera_Movement::UP, dt);
-	if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
-		DATA.camera.ProcessKeyboard(Camera_Movement::DOWN, dt);
-
-	/*
-	float speed = 4.f;
-	if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
-		DATA.objectPos.z -= speed * dt;
-	if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
-		DATA.objectPos.z += speed * dt;
-	if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
-		DATA.objectPos.x += speed * dt;
-	if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
-		DATA.objectPos.x -= speed * dt;
-	*/
-}
-
-void mouse_callback(GLFWwindow *window, double x, double y)
-{
-	ImGuiIO &io = ImGui::GetIO();
-
-	if (DATA.cursorCaptured)
-	{
-		float dx = (float)(x - DATA.lastX);
-		float dy = (float)(DATA.lastY - y);
-		DATA.lastX = x;
-		DATA.lastY = y;
-		DATA.camera.ProcessMouseMovement(dx, dy);
-	}
-}
-
-void scroll_callback(GLFWwindow *window, double dx, double dy)
-{
-	if (ImGui::GetIO().WantCaptureMouse)
-		return;
-
-	DATA.camera.ProcessMouseScroll((float)dy);
-}
-
-void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
-{
-	ImGuiIO &io = ImGui::GetIO();
-	if (action == GLFW_PRESS && !io.WantCaptureMouse)
-	{
-		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-		DATA.cursorCaptured = true;
-		glfwGetCursorPos(window, &DATA.lastX, &DATA.lastY);
-	}
-	if (action == GLFW_RELEASE)
-	{
-		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-		DATA.cursorCaptured = false;
-	}
-	if (action == GLFW_PRESS)
-	{
-		if (button == GLFW_MOUSE_BUTTON_MIDDLE)
-			DATA.camera.ResetZoom();
-	}
-}
-
-void SetLights()
-{
-	int pointLightsCount = 0, dirLightsCount = 0, spotLightsCount = 0;
-	for (const Light &light : DATA.lights)
-	{
-		std::string lightName;
-		switch (light.type)
-		{
-		case 0:
-		{
-			lightName = "pointLights[" + std::to_string(pointLightsCount++) + "]";
-			DATA.shadersManager.set(lightName + ".position", light.location);
-			DATA.shadersManager.set(lightName + ".constant", light.constant);
-			DATA.shadersManager.set(lightName + ".linear", light.linear);
-			DATA.shadersManager.set(lightName + ".quadratic", light.quadratic);
-			break;
-		}
-		case 1:
-		{
-			lightName = "dirLights[" + std::to_string(dirLightsCount++) + "]";
-			DATA.shadersManager.set(lightName + ".direction", light.direction);
-			break;
-		}
-		case 2:
-		{
-			lightName = "spotLights[" + std::to_string(spotLightsCount++) + "]";
-			DATA.shadersManager.set(lightName + ".innerCutOff", light.innerCutOff);
-			DATA.shadersManager.set(lightName + ".outerCutOff", light.outerCutOff);
-			DATA.shadersManager.set(lightName + ".direction", light.direction);
-			DATA.shadersManager.set(lightName + ".position", light.location);
-			break;
-		}
-
-		default:
-			break;
-		}
-
-		DATA.shadersManager.set(lightName + ".ambient", light.ambient);
-		DATA.shadersManager.set(lightName + ".diffuse", light.diffuse);
-		DATA.shadersManager.set(lightName + ".specular", light.specular);
-	}
-
-	DATA.shadersManager.set("dirLightsCount", dirLightsCount);
-	DATA.shadersManager.set("pointLightsCount", pointLightsCount);
-	DATA.shadersManager.set("spotLightsCount", spotLightsCount);
-}
-
-void DrawGUI()
-{
-	auto lightToDelete = DATA.lights.end();
-	int lightTypeToAdd = -1;
-
-	ImGui_ImplOpenGL3_NewFrame();
-	ImGui_ImplGlfw_NewFrame();
-	ImGui::NewFrame();
-	{
-		ImGui::Begin("Objects", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
-		if (ImGui::CollapsingHeader("Lights"))
-		{
-			int i = 0;
-			for (auto itLight = DATA.lights.begin(); itLight != DATA.lights.end(); ++itLight)
-			{
-				ImGui::PushID(++i);
-				Light &light = *itLight;
-				if (light.type == 0)
-				{
-					ImGui::Text("Point");
-					ImGui::Indent();
-					ImGui::DragFloat3("location", (float *)&light.location, 0.01f);
-				}
-				else if (light.type == 1)
-				{
-					ImGui::Text("Directional");
-					ImGui::Indent();
-					ImGui::DragFloat3("direction", (float *)&light.direction, 0.01f, -1.0f, 1.0f);
-				}
-				else if (light.type == 2)
-				{
-					ImGui::Text("Spot");
-					ImGui::Indent();
-					ImGui::DragFloat3("location", (float *)&light.location, 0.01f);
-					ImGui::DragFloat3("direction", (float *)&light.direction, 0.01f, -1.0f, 1.0f);
-					ImGui::DragFloat("innerCutOff", &light.innerCutOff, 0.001f, 0.f, 1.f);
-					ImGui::DragFloat("outerCutOff", &light.outerCutOff, 0.001f, 0.f, 1.f);
-				}
-				ImGui::ColorEdit3("ambient", (float *)&light.ambient, ImGuiColorEditFlags_Float);
-				ImGui::ColorEdit3("diffuse", (float *)&light.diffuse, ImGuiColorEditFlags_Float);
-				ImGui::ColorEdit3("specular", (float *)&light.specular, ImGuiColorEditFlags_Float);
-				if (ImGui::Button("Delete light"))
-					lightToDelete = itLight;
-
-				ImGui::Unindent();
-				ImGui::PopID();
-			}
-
-			if (ImGui::Button("AddPointLight"))
-			{
-				lightTypeToAdd = 0;
-			}
-			ImGui::SameLine();
-			if (ImGui::Button("AddDirectionalLight"))
-			{
-				lightTypeToAdd = 1;
-			}
-			ImGui::SameLine();
-			if (ImGui::Button("AddSpotLight"))
-			{
-				lightTypeToAdd = 2;
-			}
-
-			/*
-			std::stringstream sstr;
-			sstr << "lastX: " << DATA.lastX << "  lastY: " << DATA.lastY;
-			ImGui::Text(sstr.str().c_str());
-			*/
-		}
-
-		if (ImGui::CollapsingHeader("Models"))
-		{
-			int imGuiID = 0;
-			for (Model *pModel : DATA.unsortedModels)
-			{
-				Model &model = *pModel;
-				ImGui::PushID(++imGuiID);
-				ImGui::Text("%s", model.GetName().c_str());
-				ImGui::Indent();
-
-				auto location = model.GetLocation();
-				if (ImGui::DragFloat3("location", (float *)&location, 0.01f))
-					model.SetLocation(location);
-				auto scale = model.GetScale();
-				if (ImGui::DragFloat3("scale", (float *)&scale, 0.01f))
-					model.SetScale(scale);
-				auto rotation = model.GetRotation();
-				if (ImGui::DragFloat3("rotation", (float *)&rotation, 1.f))
-					model.SetRotation(rotation);
-				if (model.solidColor)
-					ImGui::ColorEdit4("color", (float *)&model.color, ImGuiColorEditFlags_Float);
-				ImGui::Checkbox("Outline", &model.outline);
-				ImGui::SetNextItemWidth(100.f);
-				ImGui::SameLine();
-				ImGui::DragFloat("Shininess", &model.shininess);
-
-				ImGui::Unindent();
-				ImGui::PopID();
-			}
-		}
-
-		if (ImGui::CollapsingHeader("Post-processing"))
-		{
-			bool changed = false;
-			changed = ImGui::RadioButton("Default", &DATA.postEffect, 0) || changed;
-			changed = ImGui::RadioButton("Inverse", &DATA.postEffect, 1) || changed;
-			changed = ImGui::RadioButton("Grayscale", &DATA.postEffect, 2) || changed;
-			changed = ImGui::RadioButton("With kernel", &DATA.postEffect, 3) || changed;
-			if (changed)
-				DATA.currentScreenShader = DATA.SCREEN_SHADER_ID + DATA.postEffect;
-
-			if (DATA.postEffect == 3)
-			{
-				ImGui::Indent();
-				changed = false;
-				changed = ImGui::RadioButton("Sharpen", &DATA.currentKernel, 0) || changed;
-				changed = ImGui::RadioButton("Blur", &DATA.currentKernel, 1) || changed;
-				changed = ImGui::RadioButton("Edge Detection", &DATA.currentKernel, 2) || changed;
-				if (changed)
-				{
-					Shader &shader = DATA.shadersManager.GetShader(DATA.SCREEN_SHADER_ID + DATA.postEffect);
-					float kernel[] = {
-						0.f, 0.f, 0.f,
-						0.f, 1.f, 0.f,
-						0.f, 0.f, 0.f};
-					switch (DATA.currentKernel)
-					{
-					case 0:
-						kernel[0] = 2.f;
-						kernel[1] = 2.f;
-						kernel[2] = 2.f;
-						kernel[3] = 2.f;
-						kernel[4] = -15.f;
-						kernel[5] = 2.f;
-						kernel[6] = 2.f;
-						kernel[7] = 2.f;
-						kernel[8] = 2.f;
-						break;
-					case 1:
-						kernel[0] = 1.f / 16.f;
-						kernel[1] = 2.f / 16.f;
-						kernel[2] = 1.f / 16.f;
-						kernel[3] = 2.f / 16.f;
-						kernel[4] = 4.f / 16.f;
-						kernel[5] = 2.f / 16.f;
-						kernel[6] = 1.f / 16.f;
-						kernel[7] = 2.f / 16.f;
-						kernel[8] = 1.f / 16.f;
-						break;
-					case 2:
-						kernel[0] = 1.f;
-						kernel[1] = 1.f;
-						kernel[2] = 1.f;
-						kernel[3] = 1.f;
-						kernel[4] = -8.f;
-						kernel[5] = 1.f;
-						kernel[6] = 1.f;
-						kernel[7] = 1.f;
-						kernel[8] = 1.f;
-						break;
-
-					default:
-						break;
-					}
-					shader.set("kernel", kernel, 9);
-				}
-				ImGui::Unindent();
-			}
-		}
-
-		ImGui::Text("Camera at (%.3f, %.3f, %.3f)", DATA.camera.Position.x, DATA.camera.Position.y, DATA.camera.Position.z);
-		ImGui::Indent();
-		ImGui::Text("looking at (%.3f, %.3f, %.3f)", DATA.camera.Front.x, DATA.camera.Front.y, DATA.camera.Front.z);
-		ImGui::Unindent();
-		ImGui::Text("FPS: %.2f", ImGui::GetIO().Framerate);
-
-		if (ImGui::Checkbox("Face culling", &DATA.faceCulling))
-			glSet(GL_CULL_FACE, DATA.faceCulling);
-
-		if (ImGui::Checkbox("Evening", &DATA.evening))
-		{
-			int shaderID = DATA.shadersManager.GetShaderID("vertex_skybox.glsl", "fragment_skybox.glsl");
-			auto& shader = DATA.shadersManager.GetShader(shaderID);
-			shader.use();
-			shader.set("evening", DATA.evening);
-		}
-
-		ImGui::End();
-	}
-	ImGui::Render();
-	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-	if (lightToDelete != DATA.lights.end())
-		DATA.lights.erase(lightToDelete);
-	if (lightTypeToAdd != -1)
-		DATA.lights.emplace_back(lightTypeToAdd);
-}
-
-void SortModelsByDepth()
-{
-	std::sort(DATA.models.begin(), DATA.models.end(), [](const Model *model1, const Model *model2) {
-		if (model2->opaque)
-			return false;
-		if (model1->opaque)
-			return true;
-
-		float dist1 = glm::distance(DATA.camera.Position, model1->GetLocation());
-		float dist2 = glm::distance(DATA.camera.Position, model2->GetLocation());
-
-		return dist1 > dist2;
-	});
-}
-
-void LoadSceneFromJSON()
-{
-	std::ifstream i("scenes/scene.json");
-	json jScene;
-	try
-	{
-		i >> jScene;
-	}
-	catch (const nlohmann::detail::exception &ex)
-	{
-		std::cerr << ex.what() << std::endl;
-		exit(1);
-	}
-
-	for (auto &jLight : jScene["Lights"])
-	{
-		Light light(jLight.value("type", 0));
-		light.ambient = getVec3(jLight.value("ambient", std::vector<float>{0.1f, 0.1f, 0.1f}));
-		light.diffuse = getVec3(jLight.value("diffuse", std::vector<float>{1.0f, 1.0f, 1.0f}));
-		light.specular = getVec3(jLight.value("specular", std::vector<float>{1.0f, 1.0f, 1.0f}));
-
-		light.constant = jLight.value("constant", 1.f);
-		light.linear = jLight.value("linear", 0.09f);
-		light.quadratic = jLight.value("quadratic", 0.032f);
-
-		light.location = getVec3(jLight.value("location", std::vector<float>{0.0f, 0.0f, 0.0f}));
-		light.direction = getVec3(jLight.value("direction", std::vector<float>{-0.5f, -1.0f, -0.3f}));
-
-		light.innerCutOff = jLight.value("innerCutOff", 0.97629600712f);
-		light.outerCutOff = jLight.value("outerCutOff", 0.95371695074f);
-
-		DATA.lights.push_back(light);
-	}
-
-	for (auto &jModel : jScene["Models"])
-	{
-		int shaderID = DATA.shadersManager.GetShaderID(jModel["vShader"].get<std::string>().c_str(), jModel["fShader"].get<std::string>().c_str());
-		Model *model = nullptr;
-		if (jModel.find("path") != jModel.end())
-		{
-			model = new Model(jModel["path"].get<std::string>().c_str(), shaderID);
-		}
-		else
-		{
-			std::vector<Vertex> vertices;
-			vertices.push_back(Vertex{glm::vec3{-0.5f, -0.5f, 0.f}, glm::vec3{0.f, 0.f, 1.f}, glm::vec2{0.f, 1.f}});
-			vertices.push_back(Vertex{glm::vec3{0.5f, -0.5f, 0.f}, glm::vec3{0.f, 0.f, 1.f}, glm::vec2{1.f, 1.f}});
-			vertices.push_back(Vertex{glm::vec3{-0.5f, 0.5f, 0.f}, glm::vec3{0.f, 0.f, 1.f}, glm::vec2{0.f, 0.f}});
-			vertices.push_back(Vertex{glm::vec3{0.5f, 0.5f, 0.f}, glm::vec3{0.f, 0.f, 1.f}, glm::vec2{1.f, 0.f}});
-			std::vector<GLuint> indices{0, 1, 2, 1, 3, 2};
-
-			Texture texture;
-			texture.id = TextureFromFile(jModel.value("texture", "").c_str(), "");
-			texture.type = "texture_diffuse";
-
-			Mesh mesh2D{vertices, indices, std::vector<Texture>{texture}};
-			model = new Model{mesh2D, shaderID};
-		}
-		if (!model)
-			continue;
-
-		model->SetLocation(getVec3(jModel.value("location", std::vector<float>{0.f, 0.f, 0.f})));
-		model->SetScale(getVec3(jModel.value("scale", std::vector<float>{1.f, 1.f, 1.f})));
-		model->color = glm::vec4{getVec3(jModel.value("color", std::vector<float>{0.f, 0.f, 0.f})), 1.f};
-		model->opaque = jModel.value("opaque", false);
-		model->solidColor = jModel.value("solidColor", false);
-		model->outline = jModel.value("outline", false);
-		if (jModel.find("name") != jModel.end())
-			model->ChangeName(jModel.value("name", ""));
-		model->transparentCube = jModel.value("transparentCube", false);
-		if (model->transparentCube)
-			model->SortFaces();
-		DATA.models.push_back(model);
-	}
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <cmath>
+#include <map>
+#include <memory>
+
+#include "imgui.h"
+#include "imgui_impl_glfw.h"
+#include "imgui_impl_opengl3.h"
+
+#include "shader.h"
+#include "ShadersManager.h"
+#include "stb_image.h"
+#include "model.h"
+#include "Framebuffer.h"
+#include "GLState.h"
+#include "GLExtensions.h"
+#include "FrameData.h"
+#include "LightBuffer.h"
+#include "GeometryArena.h"
+#include "AssetRegistry.h"
+#include "MemoryTracker.h"
+#include "SceneLoader.h"
+#include "TextureStreamer.h"
+#include "MappedIOSystem.h"
+#include "QuadBatcher.h"
+#include "skybox.h"
+#include "Trace.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+#include "globalData.h"
+const glm::vec3 GlobalData::DEFAULT_CAMERA_POS{0.f, 1.5f, 3.f};
+
+void processInput(GLFWwindow *window, float dt);
+void mouse_callback(GLFWwindow *window, double x, double y);
+void mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
+void scroll_callback(GLFWwindow *window, double dx, double dy);
+GLuint loadTexture(const char *path);
+void SortModelsByDepth();
+
+void DrawGUI();
+void LoadSceneFromJSON(SceneLoader &loader, QuadBatcher &quads);
+
+glm::vec3 getVec3(const std::vector<float> vec)
+{
+	return {vec[0], vec[1], vec[2]};
+}
+
+// Records a startup phase that began at `begin`, returns the start of the next one
+double endPhase(const char *name, double begin)
+{
+	const double end = Trace::Now();
+	Trace::Record("startup", name, begin, end);
+	return end;
+}
+
+void error_callback(int error, const char *description)
+{
+	std::cerr << "Error: " << description << std::endl;
+}
+
+void framebuffer_size_callback(GLFWwindow *wnd, int width, int height)
+{
+	glViewport(0, 0, width, height);
+	DATA.width = (float)width;
+	DATA.height = (float)height;
+}
+
+void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods)
+{
+	if (ImGui::GetIO().WantCaptureKeyboard)
+		return;
+
+	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+		glfwSetWindowShouldClose(window, GLFW_TRUE);
+	if (key == GLFW_KEY_ENTER && action == GLFW_PRESS)
+	{
+		if (DATA.mode == GL_LINE)
+			DATA.mode = GL_FILL;
+		else
+			DATA.mode = GL_LINE;
+		glPolygonMode(GL_FRONT_AND_BACK, DATA.mode);
+	}
+	if (key == GLFW_KEY_BACKSPACE && action == GLFW_PRESS)
+		DATA.camera.Position = GlobalData::DEFAULT_CAMERA_POS;
+	if (key == GLFW_KEY_TAB && action == GLFW_PRESS)
+		DATA.drawLight = !DATA.drawLight;
+}
+
+int main(int argc, char **argv)
+{
+	GLFWwindow *wnd;
+	Trace::SetThreadName("main");
+	double phaseStart = Trace::Now();
+
+	if (!glfwInit())
+		return -1;
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+	// global callbacks
+	glfwSetErrorCallback(error_callback);
+
+	wnd = glfwCreateWindow((int)DATA.width, (int)DATA.height, "Yo, GLFW!", NULL, NULL);
+	if (!wnd)
+	{
+		glfwTerminate();
+		return -1;
+	}
+
+	// window callbacks
+	glfwSetKeyCallback(wnd, key_callback);
+	glfwSetFramebufferSizeCallback(wnd, framebuffer_size_callback);
+	glfwSetCursorPosCallback(wnd, mouse_callback);
+	glfwSetScrollCallback(wnd, scroll_callback);
+	glfwSetMouseButtonCallback(wnd, mouse_button_callback);
+
+	glfwSetInputMode(wnd, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+
+	glfwMakeContextCurrent(wnd);
+
+	if (glfwRawMouseMotionSupported())
+		glfwSetInputMode(wnd, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
+	phaseStart = endPhase("GLFW init", phaseStart);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cerr << "Failed to initialize GLAD" << std::endl;
+		return -1;
+	}
+	GLExt::Load((GLADloadproc)glfwGetProcAddress);
+	phaseStart = endPhase("GLAD init", phaseStart);
+
+	ShadersManager &shadersManager = DATA.shadersManager;
+
+	glViewport(0, 0, (GLsizei)DATA.width, (GLsizei)DATA.height);
+	GLState::Enable(GL_BLEND);
+	glSet(GL_CULL_FACE, DATA.faceCulling);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glStencilOp(GL_REPLACE, GL_REPLACE, GL_REPLACE);
+	glDepthFunc(GL_LEQUAL);
+
+	Framebuffer frameBuffer((GLsizei)DATA.width, (GLsizei)DATA.height, {0.1f, 0.1f, 0.1f, 1.0f});
+	UniformBuffer frameDataBuffer(FRAME_DATA_BINDING, sizeof(FrameData));
+	LightBuffer lightBuffer;
+
+	IMGUI_CHECKVERSION();
+	ImGui::CreateContext();
+	ImGuiIO &io = ImGui::GetIO();
+
+	ImGui::StyleColorsDark();
+	ImGui_ImplGlfw_InitForOpenGL(wnd, true);
+	ImGui_ImplOpenGL3_Init("#version 330 core");
+	phaseStart = endPhase("Framebuffer and ImGui", phaseStart);
+
+	int modelShaderID = shadersManager.CreateShader("shaders/vertex.glsl", "shaders/fragment.glsl");
+	int lightShaderID = shadersManager.CreateShader("shaders/vertex_lamp.glsl", "shaders/fragment_lamp.glsl");
+	int solidShaderID = shadersManager.CreateShader("shaders/vertex_solid.glsl", "shaders/fragment_solid.glsl");
+	int textureShaderID = shadersManager.CreateShader("shaders/vertex_2D.glsl", "shaders/fragment_model.glsl");
+
+	// screen shaders
+	int screenShaderID = shadersManager.CreateShader("shaders/vertex_quad.glsl", "shaders/fragment_quad.glsl");
+	DATA.SCREEN_SHADER_ID = screenShaderID;
+	DATA.currentScreenShader = screenShaderID;
+	int inverseShaderID = shadersManager.CreateShader("shaders/vertex_quad.glsl", "shaders/fragment_quad_inverse.glsl");
+	int grayscaleShaderID = shadersManager.CreateShader("shaders/vertex_quad.glsl", "shaders/fragment_quad_grayscale.glsl");
+	int kernelShaderID = shadersManager.CreateShader("shaders/vertex_quad.glsl", "shaders/fragment_quad_kernel.glsl");
+
+	int skyboxShaderID = shadersManager.CreateShader("shaders/vertex_skybox.glsl", "shaders/fragment_skybox.glsl");
+	phaseStart = endPhase("Create shaders", phaseStart);
+
+	// models are imported on worker threads and show up as their uploads finish
+	SceneLoader sceneLoader;
+	const size_t UPLOAD_BUDGET_BYTES = 8 << 20; // per frame
+	const float loadStartTime = (float)glfwGetTime();
+	const double sceneLoadStart = Trace::Now();
+
+	Model spotLightModel(std::string{"shapes/cone.nff"}, lightShaderID, nullptr);
+	Model pointLightModel(std::string{"shapes/sphere.nff"}, lightShaderID, nullptr);
+	sceneLoader.LoadModel(&spotLightModel, "shapes/cone.nff", ImportOptions{});
+	sceneLoader.LoadModel(&pointLightModel, "shapes/sphere.nff", ImportOptions{});
+	phaseStart = endPhase("Light gizmos", phaseStart);
+
+	// decoded on its own workers while the scene loads
+	Skybox skybox(skyboxShaderID);
+	skybox.Load({"textures/skybox/right.jpg",
+				 "textures/skybox/left.jpg",
+				 "textures/skybox/top.jpg",
+				 "textures/skybox/bottom.jpg",
+				 "textures/skybox/front.jpg",
+				 "textures/skybox/back.jpg"});
+	phaseStart = endPhase("Skybox", phaseStart);
+
+	// Scene description >>>
+	QuadBatcher quadBatcher;
+	DATA.quadBatcher = &quadBatcher;
+	LoadSceneFromJSON(sceneLoader, quadBatcher);
+	for (Model *model : DATA.models)
+		DATA.unsortedModels.push_back(model);
+	// Scene description <<<
+	endPhase("LoadSceneFromJSON", phaseStart);
+	bool sceneLoading = true;
+
+	float dt = 0.f;
+	float lastFrame = 0.f;
+	while (!glfwWindowShouldClose(wnd))
+	{
+		float currentFrame = (float)glfwGetTime();
+		dt = currentFrame - lastFrame;
+		lastFrame = currentFrame;
+		processInput(wnd, dt);
+
+		GLState::BeginFrame();
+		Shader::BeginFrame();
+		shadersManager.PollPending();
+		if (sceneLoading)
+			DATA.pendingModels = sceneLoader.Update(UPLOAD_BUDGET_BYTES);
+		TextureStreamer::Update();
+		if (sceneLoading && DATA.pendingModels == 0)
+		{
+			sceneLoading = false;
+			Trace::Record("startup", "Scene load", sceneLoadStart, Trace::Now());
+			std::cout << "Scene loaded in " << (float)glfwGetTime() - loadStartTime << " s" << std::endl;
+			const AssetRegistryStats assetStats = AssetRegistry::Stats();
+			std::cout << "Asset registry: " << assetStats.hits << " hits, " << assetStats.misses << " misses, "
+					  << assetStats.liveModels << " models, " << assetStats.liveTextures << " textures" << std::endl;
+			const ProgramCacheStats &programCache = Shader::CacheStats();
+			std::cout << "Program binary cache: " << programCache.hits << " hits, " << programCache.misses << " misses ("
+					  << programCache.rejected << " rejected)" << std::endl;
+			// nothing imports after the scene, unmap the model and texture sources
+			MappedIOSystem::ClearCache();
+		}
+		GLState::Enable(GL_DEPTH_TEST);
+		GLState::Enable(GL_STENCIL_TEST);
+		frameBuffer.Use();
+
+		lightBuffer.Update(DATA.lights, DATA.lightsVersion);
+
+		FrameData frameData;
+		frameData.view = DATA.camera.GetViewMatrix();
+		frameData.projection = glm::perspective(glm::radians(DATA.camera.Zoom), DATA.width / DATA.height, 0.1f, 100.f);
+		frameData.viewPos = DATA.camera.Position;
+		frameData.time = currentFrame;
+		frameData.resolution = {DATA.width, DATA.height};
+		frameDataBuffer.Upload(frameData);
+
+		SortModelsByDepth();
+		quadBatcher.Prepare(frameData.view, frameData.projection, DATA.camera.Position);
+
+		// runs of models sharing meshes, shader and material are drawn instanced, the sorted order is kept
+		for (size_t first = 0; first < DATA.models.size();)
+		{
+			size_t last = first + 1;
+			while (last < DATA.models.size() && DATA.models[first]->CanInstanceWith(*DATA.models[last]))
+				++last;
+
+			// quads are sorted separately, the ones behind this transparent model go first
+			if (!DATA.models[first]->opaque)
+				quadBatcher.DrawFartherThan(glm::distance(DATA.camera.Position, DATA.models[first]->GetLocation()));
+			if (DATA.models[first]->outline)
+			{
+				GLState::StencilFunc(GL_ALWAYS, 1, 0xFF);
+				GLState::StencilMask(0xFF);
+			}
+			else
+			{
+				GLState::StencilMask(0x00);
+			}
+			if (last - first == 1 || !Model::DrawInstanced(&DATA.models[first], last - first))
+			{
+				for (size_t i = first; i < last; ++i)
+					DATA.models[i]->DrawModel();
+			}
+			first = last;
+		}
+		quadBatcher.DrawRemaining();
+
+		for (Light &light : DATA.lights)
+		{
+			if (light.type == 0)
+			{
+				pointLightModel.SetLocation(light.location);
+				pointLightModel.color = glm::vec4{light.diffuse, 1.f};
+				pointLightModel.SetScale({0.1f, 0.1f, 0.1f});
+				pointLightModel.DrawPointLight();
+			}
+			else if (light.type == 2)
+			{
+				spotLightModel.color = glm::vec4{light.diffuse, 1.f};
+				spotLightModel.SetScale({0.2f, 0.2f, 0.2f});
+				spotLightModel.SetLocation(light.location);
+
+				static const glm::vec3 up{0.f, 1.f, 0.f};
+				glm::vec3 axis = glm::cross(up, glm::normalize(light.direction));
+				float angle = glm::acos(glm::dot(up, glm::normalize(light.direction)));
+				spotLightModel.DrawSpotLight(angle, axis);
+			}
+		}
+		
+		skybox.Draw();
+
+		for (Model *model : DATA.models)
+		{
+			if (!model->outline)
+				continue;
+
+			// render outline >>>
+			GLState::StencilFunc(GL_NOTEQUAL, 1, 0xFF);
+			GLState::StencilMask(0x00);
+			GLState::Disable(GL_DEPTH_TEST);
+
+			auto tmpShader = model->shaderID;
+			model->shaderID = solidShaderID;
+
+			model->DrawModel();
+
+			model->shaderID = tmpShader;
+
+			GLState::StencilFunc(GL_ALWAYS, 1, 0xFF);
+			GLState::StencilMask(0xFF);
+			GLState::Enable(GL_DEPTH_TEST);
+			// render outline <<<
+		}
+
+		Shader &screenShader = shadersManager.GetShader(DATA.currentScreenShader);
+		if (screenShader.IsReady())
+		{
+			screenShader.use();
+			frameBuffer.Draw();
+		}
+		else
+		{
+			frameBuffer.Unbind();
+		}
+
+		DrawGUI();
+
+		glfwSwapBuffers(wnd);
+		glfwPollEvents();
+	}
+
+	Trace::Write("trace.json");
+	AssetRegistry::OnContextDestroyed();
+	glfwTerminate();
+	return 0;
+}
+
+void processInput(GLFWwindow *window, float dt)
+{
+	if (ImGui::GetIO().WantCaptureKeyboard)
+		return;
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+		DATA.camera.ProcessKeyboard(Camera_Movement::FORWARD, dt);
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+		DATA.camera.ProcessKeyboard(Camera_Movement::BACKWARD, dt);
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+		DATA.camera.ProcessKeyboard(Camera_Movement::LEFT, dt);
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+		DATA.camera.ProcessKeyboard(Camera_Movement::RIGHT, dt);
+	if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
+		DATA.camera.ProcessKeyboard(Camera_Movement::UP, dt);
+	if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
+		DATA.camera.ProcessKeyboard(Camera_Movement::DOWN, dt);
+
+	/*
+	float speed = 4.f;
+	if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
+		DATA.objectPos.z -= speed * dt;
+	if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
+		DATA.objectPos.z += speed * dt;
+	if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
+		DATA.objectPos.x += speed * dt;
+	if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
+		DATA.objectPos.x -= speed * dt;
+	*/
+}
+
+void mouse_callback(GLFWwindow *window, double x, double y)
+{
+	ImGuiIO &io = ImGui::GetIO();
+
+	if (DATA.cursorCaptured)
+	{
+		float dx = (float)(x - DATA.lastX);
+		float dy = (float)(DATA.lastY - y);
+		DATA.lastX = x;
+		DATA.lastY = y;
+		DATA.camera.ProcessMouseMovement(dx, dy);
+	}
+}
+
+void scroll_callback(GLFWwindow *window, double dx, double dy)
+{
+	if (ImGui::GetIO().WantCaptureMouse)
+		return;
+
+	DATA.camera.ProcessMouseScroll((float)dy);
+}
+
+void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
+{
+	ImGuiIO &io = ImGui::GetIO();
+	if (action == GLFW_PRESS && !io.WantCaptureMouse)
+	{
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		DATA.cursorCaptured = true;
+		glfwGetCursorPos(window, &DATA.lastX, &DATA.lastY);
+	}
+	if (action == GLFW_RELEASE)
+	{
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+		DATA.cursorCaptured = false;
+	}
+	if (action == GLFW_PRESS)
+	{
+		if (button == GLFW_MOUSE_BUTTON_MIDDLE)
+			DATA.camera.ResetZoom();
+	}
+}
+
+void DrawGUI()
+{
+	auto lightToDelete = DATA.lights.end();
+	int lightTypeToAdd = -1;
+
+	ImGui_ImplOpenGL3_NewFrame();
+	ImGui_ImplGlfw_NewFrame();
+	ImGui::NewFrame();
+	{
+		ImGui::Begin("Objects", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+		if (ImGui::CollapsingHeader("Lights"))
+		{
+			int i = 0;
+			for (auto itLight = DATA.lights.begin(); itLight != DATA.lights.end(); ++itLight)
+			{
+				ImGui::PushID(++i);
+				Light &light = *itLight;
+				if (light.type == 0)
+				{
+					ImGui::Text("Point");
+					ImGui::Indent();
+					if (ImGui::DragFloat3("location", (float *)&light.location, 0.01f))
+						DATA.LightsChanged();
+				}
+				else if (light.type == 1)
+				{
+					ImGui::Text("Directional");
+					ImGui::Indent();
+					if (ImGui::DragFloat3("direction", (float *)&light.direction, 0.01f, -1.0f, 1.0f))
+						DATA.LightsChanged();
+				}
+				else if (light.type == 2)
+				{
+					ImGui::Text("Spot");
+					ImGui::Indent();
+					bool changed = false;
+					changed = ImGui::DragFloat3("location", (float *)&light.location, 0.01f) || changed;
+					changed = ImGui::DragFloat3("direction", (float *)&light.direction, 0.01f, -1.0f, 1.0f) || changed;
+					changed = ImGui::DragFloat("innerCutOff", &light.innerCutOff, 0.001f, 0.f, 1.f) || changed;
+					changed = ImGui::DragFloat("outerCutOff", &light.outerCutOff, 0.001f, 0.f, 1.f) || changed;
+					if (changed)
+						DATA.LightsChanged();
+				}
+				bool colorChanged = false;
+				colorChanged = ImGui::ColorEdit3("ambient", (float *)&light.ambient, ImGuiColorEditFlags_Float) || colorChanged;
+				colorChanged = ImGui::ColorEdit3("diffuse", (float *)&light.diffuse, ImGuiColorEditFlags_Float) || colorChanged;
+				colorChanged = ImGui::ColorEdit3("specular", (float *)&light.specular, ImGuiColorEditFlags_Float) || colorChanged;
+				if (colorChanged)
+					DATA.LightsChanged();
+				if (ImGui::Button("Delete light"))
+					lightToDelete = itLight;
+
+				ImGui::Unindent();
+				ImGui::PopID();
+			}
+
+			if (ImGui::Button("AddPointLight"))
+			{
+				lightTypeToAdd = 0;
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("AddDirectionalLight"))
+			{
+				lightTypeToAdd = 1;
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("AddSpotLight"))
+			{
+				lightTypeToAdd = 2;
+			}
+
+			/*
+			std::stringstream sstr;
+			sstr << "lastX: " << DATA.lastX << "  lastY: " << DATA.lastY;
+			ImGui::Text(sstr.str().c_str());
+			*/
+		}
+
+		if (ImGui::CollapsingHeader("Models"))
+		{
+			int imGuiID = 0;
+			for (Model *pModel : DATA.unsortedModels)
+			{
+				Model &model = *pModel;
+				ImGui::PushID(++imGuiID);
+				ImGui::Text("%s", model.GetName().c_str());
+				ImGui::Indent();
+
+				auto location = model.GetLocation();
+				if (ImGui::DragFloat3("location", (float *)&location, 0.01f))
+					model.SetLocation(location);
+				auto scale = model.GetScale();
+				if (ImGui::DragFloat3("scale", (float *)&scale, 0.01f))
+					model.SetScale(scale);
+				auto rotation = model.GetRotation();
+				if (ImGui::DragFloat3("rotation", (float *)&rotation, 1.f))
+					model.SetRotation(rotation);
+				if (model.solidColor)
+					ImGui::ColorEdit4("color", (float *)&model.color, ImGuiColorEditFlags_Float);
+				ImGui::Checkbox("Outline", &model.outline);
+				ImGui::SetNextItemWidth(100.f);
+				ImGui::SameLine();
+				ImGui::DragFloat("Shininess", &model.shininess);
+
+				ImGui::Unindent();
+				ImGui::PopID();
+			}
+		}
+
+		if (ImGui::CollapsingHeader("Quads"))
+		{
+			int imGuiID = 0;
+			for (size_t i = 0; i < DATA.quadBatcher->QuadCount(); ++i)
+			{
+				Quad &quad = DATA.quadBatcher->GetQuad(i);
+				ImGui::PushID(++imGuiID);
+				ImGui::Text("%s", quad.name.c_str());
+				ImGui::Indent();
+
+				ImGui::DragFloat3("location", (float *)&quad.center, 0.01f);
+				ImGui::DragFloat2("size", (float *)&quad.size, 0.01f);
+				if (quad.solidColor)
+					ImGui::ColorEdit4("color", (float *)&quad.color, ImGuiColorEditFlags_Float);
+				ImGui::Checkbox("Billboard", &quad.billboard);
+
+				ImGui::Unindent();
+				ImGui::PopID();
+			}
+		}
+
+		if (ImGui::CollapsingHeader("Post-processing"))
+		{
+			bool changed = false;
+			changed = ImGui::RadioButton("Default", &DATA.postEffect, 0) || changed;
+			changed = ImGui::RadioButton("Inverse", &DATA.postEffect, 1) || changed;
+			changed = ImGui::RadioButton("Grayscale", &DATA.postEffect, 2) || changed;
+			changed = ImGui::RadioButton("With kernel", &DATA.postEffect, 3) || changed;
+			if (changed)
+				DATA.currentScreenShader = DATA.SCREEN_SHADER_ID + DATA.postEffect;
+
+			if (DATA.postEffect == 3)
+			{
+				ImGui::Indent();
+				changed = false;
+				changed = ImGui::RadioButton("Sharpen", &DATA.currentKernel, 0) || changed;
+				changed = ImGui::RadioButton("Blur", &DATA.currentKernel, 1) || changed;
+				changed = ImGui::RadioButton("Edge Detection", &DATA.currentKernel, 2) || changed;
+				Shader &shader = DATA.shadersManager.GetShader(DATA.SCREEN_SHADER_ID + DATA.postEffect);
+				if (changed && shader.IsReady())
+				{
+					float kernel[] = {
+						0.f, 0.f, 0.f,
+						0.f, 1.f, 0.f,
+						0.f, 0.f, 0.f};
+					switch (DATA.currentKernel)
+					{
+					case 0:
+						kernel[0] = 2.f;
+						kernel[1] = 2.f;
+						kernel[2] = 2.f;
+						kernel[3] = 2.f;
+						kernel[4] = -15.f;
+						kernel[5] = 2.f;
+						kernel[6] = 2.f;
+						kernel[7] = 2.f;
+						kernel[8] = 2.f;
+						break;
+					case 1:
+						kernel[0] = 1.f / 16.f;
+						kernel[1] = 2.f / 16.f;
+						kernel[2] = 1.f / 16.f;
+						kernel[3] = 2.f / 16.f;
+						kernel[4] = 4.f / 16.f;
+						kernel[5] = 2.f / 16.f;
+						kernel[6] = 1.f / 16.f;
+						kernel[7] = 2.f / 16.f;
+						kernel[8] = 1.f / 16.f;
+						break;
+					case 2:
+						kernel[0] = 1.f;
+						kernel[1] = 1.f;
+						kernel[2] = 1.f;
+						kernel[3] = 1.f;
+						kernel[4] = -8.f;
+						kernel[5] = 1.f;
+						kernel[6] = 1.f;
+						kernel[7] = 1.f;
+						kernel[8] = 1.f;
+						break;
+
+					default:
+						break;
+					}
+					shader.use();
+					shader.set(Uniforms::kernel, kernel, 9);
+				}
+				ImGui::Unindent();
+			}
+		}
+
+		if (ImGui::CollapsingHeader("GL state"))
+		{
+			const GLState::Stats &stats = GLState::LastFrameStats();
+			unsigned issued = 0, skipped = 0;
+			ImGui::Columns(3, "glStateColumns");
+			ImGui::Text("Call");
+			ImGui::NextColumn();
+			ImGui::Text("Issued");
+			ImGui::NextColumn();
+			ImGui::Text("Skipped");
+			ImGui::NextColumn();
+			for (int call = 0; call < GLState::CALLS_COUNT; ++call)
+			{
+				ImGui::Text("%s", GLState::CallName((GLState::Call)call));
+				ImGui::NextColumn();
+				ImGui::Text("%u", stats.issued[call]);
+				ImGui::NextColumn();
+				ImGui::Text("%u", stats.skipped[call]);
+				ImGui::NextColumn();
+				issued += stats.issued[call];
+				skipped += stats.skipped[call];
+			}
+			ImGui::Columns(1);
+			ImGui::Text("Total: %u issued, %u skipped", issued, skipped);
+			const UniformUploadStats &uniformStats = Shader::LastFrameUniformStats();
+			ImGui::Text("Uniforms: %u uploaded, %u skipped", uniformStats.uploaded, uniformStats.skipped);
+		}
+
+		if (ImGui::CollapsingHeader("Level of detail"))
+		{
+			size_t drawnTriangles = 0, fullTriangles = 0;
+			for (Model *model : DATA.models)
+			{
+				drawnTriangles += model->LodTrianglesCount(model->GetLod());
+				fullTriangles += model->LodTrianglesCount(0);
+				if (model->LodCount() <= 1)
+					continue;
+				ImGui::Text("%s: LOD %d", model->GetName().c_str(), model->GetLod());
+				ImGui::Indent();
+				for (int lod = 0; lod < model->LodCount(); ++lod)
+					ImGui::Text("LOD %d: %d triangles", lod, (int)model->LodTrianglesCount(lod));
+				ImGui::Unindent();
+			}
+			ImGui::Text("Scene: %d of %d triangles", (int)drawnTriangles, (int)fullTriangles);
+		}
+
+		if (ImGui::CollapsingHeader("Geometry arena"))
+		{
+			const char* formatNames[VERTEX_FORMATS_COUNT] = {"Full precision", "Packed"};
+			for (int format = 0; format < VERTEX_FORMATS_COUNT; ++format)
+			{
+				const GeometryArenaStats stats = GeometryArena::Stats((VertexFormat)format);
+				ImGui::Text("%s: %u meshes", formatNames[format], stats.allocations);
+				ImGui::Indent();
+				ImGui::Text("Vertices: %.2f / %.2f MB, %d free blocks, %.0f%% fragmented", stats.vertexUsed / 1048576.f, stats.vertexCapacity / 1048576.f, (int)stats.vertexFreeBlocks, stats.VertexFragmentation() * 100.f);
+				ImGui::Text("Indices: %.2f / %.2f MB, %d free blocks, %.0f%% fragmented", stats.indexUsed / 1048576.f, stats.indexCapacity / 1048576.f, (int)stats.indexFreeBlocks, stats.IndexFragmentation() * 100.f);
+				ImGui::Unindent();
+			}
+		}
+
+		if (ImGui::CollapsingHeader("Memory"))
+		{
+			ImGui::Text("GPU: %.2f MB, host: %.2f MB", MemoryTracker::GPUBytes() / 1048576.f, MemoryTracker::HostBytes() / 1048576.f);
+			for (int category = 0; category < MEMORY_CATEGORIES_COUNT; ++category)
+			{
+				const auto &entries = MemoryTracker::Entries((MemoryCategory)category);
+				if (ImGui::TreeNode(MemoryTracker::CategoryName((MemoryCategory)category), "%s: %.2f MB in %d objects", MemoryTracker::CategoryName((MemoryCategory)category),
+					MemoryTracker::Bytes((MemoryCategory)category) / 1048576.f, (int)entries.size()))
+				{
+					for (const auto &entry : entries)
+						ImGui::Text("%s: %.1f KB", entry.second.name.c_str(), entry.second.bytes / 1024.f);
+					ImGui::TreePop();
+				}
+			}
+			if (ImGui::Button("Dump to memory.json"))
+			{
+				std::ofstream dump("memory.json");
+				MemoryTracker::Dump(dump);
+			}
+		}
+
+		ImGui::Text("Camera at (%.3f, %.3f, %.3f)", DATA.camera.Position.x, DATA.camera.Position.y, DATA.camera.Position.z);
+		ImGui::Indent();
+		ImGui::Text("looking at (%.3f, %.3f, %.3f)", DATA.camera.Front.x, DATA.camera.Front.y, DATA.camera.Front.z);
+		ImGui::Unindent();
+		ImGui::Text("FPS: %.2f", ImGui::GetIO().Framerate);
+		if (ImGui::Button("Write trace.json"))
+			Trace::Write("trace.json");
+		ImGui::Text("Program cache: %u hits, %u misses", Shader::CacheStats().hits, Shader::CacheStats().misses);
+		const AssetRegistryStats assetStats = AssetRegistry::Stats();
+		ImGui::Text("Assets: %u hits, %u misses, %d models, %d textures", assetStats.hits, assetStats.misses, (int)assetStats.liveModels, (int)assetStats.liveTextures);
+		size_t pendingPrograms = DATA.shadersManager.PendingCount();
+		if (pendingPrograms > 0)
+			ImGui::Text("Compiling shaders: %d left", (int)pendingPrograms);
+		if (DATA.pendingModels > 0)
+			ImGui::Text("Loading models: %d left", (int)DATA.pendingModels);
+		const TextureStreamerStats streamerStats = TextureStreamer::Stats();
+		if (streamerStats.pendingTextures > 0)
+			ImGui::Text("Streaming textures: %d left, %.1f MB (%.1f MB last frame)", (int)streamerStats.pendingTextures,
+						streamerStats.pendingBytes / 1048576.f, streamerStats.uploadedLastFrame / 1048576.f);
+		const QuadBatcherStats &quadStats = DATA.quadBatcher->Stats();
+		ImGui::Text("Quads: %d of %d visible, %d draw calls, %d atlas pages", (int)quadStats.visible, (int)quadStats.quads,
+					(int)quadStats.drawCalls, (int)quadStats.pages);
+		int streamBudgetKB = (int)(TextureStreamer::budgetBytesPerFrame >> 10);
+		if (ImGui::SliderInt("Texture upload KB/frame", &streamBudgetKB, 64, 16384))
+			TextureStreamer::budgetBytesPerFrame = size_t(streamBudgetKB) << 10;
+
+		if (ImGui::Checkbox("Face culling", &DATA.faceCulling))
+			glSet(GL_CULL_FACE, DATA.faceCulling);
+
+		if (ImGui::Checkbox("Evening", &DATA.evening))
+		{
+			int shaderID = DATA.shadersManager.GetShaderID("vertex_skybox.glsl", "fragment_skybox.glsl");
+			auto& shader = DATA.shadersManager.GetShader(shaderID);
+			if (shader.IsReady())
+			{
+				shader.use();
+				shader.set(Uniforms::evening, DATA.evening);
+			}
+		}
+
+		ImGui::End();
+	}
+	ImGui::Render();
+	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+	if (lightToDelete != DATA.lights.end())
+	{
+		DATA.lights.erase(lightToDelete);
+		DATA.LightsChanged();
+	}
+	if (lightTypeToAdd != -1)
+	{
+		DATA.lights.emplace_back(lightTypeToAdd);
+		DATA.LightsChanged();
+	}
+}
+
+void SortModelsByDepth()
+{
+	std::sort(DATA.models.begin(), DATA.models.end(), [](const Model *model1, const Model *model2) {
+		// opaque models don't need an order, keep the ones that can be instanced together next to each other
+		if (model1->opaque && model2->opaque)
+			return std::make_pair(model1->InstanceKey(), model1->shaderID) < std::make_pair(model2->InstanceKey(), model2->shaderID);
+		if (model2->opaque)
+			return false;
+		if (model1->opaque)
+			return true;
+
+		float dist1 = glm::distance(DATA.camera.Position, model1->GetLocation());
+		float dist2 = glm::distance(DATA.camera.Position, model2->GetLocation());
+
+		return dist1 > dist2;
+	});
+}
+
+void LoadSceneFromJSON(SceneLoader &loader, QuadBatcher &quads)
+{
+	std::ifstream i("scenes/scene.json");
+	json jScene;
+	try
+	{
+		i >> jScene;
+	}
+	catch (const nlohmann::detail::exception &ex)
+	{
+		std::cerr << ex.what() << std::endl;
+		exit(1);
+	}
+
+	for (auto &jLight : jScene["Lights"])
+	{
+		Light light(jLight.value("type", 0));
+		light.ambient = getVec3(jLight.value("ambient", std::vector<float>{0.1f, 0.1f, 0.1f}));
+		light.diffuse = getVec3(jLight.value("diffuse", std::vector<float>{1.0f, 1.0f, 1.0f}));
+		light.specular = getVec3(jLight.value("specular", std::vector<float>{1.0f, 1.0f, 1.0f}));
+
+		light.constant = jLight.value("constant", 1.f);
+		light.linear = jLight.value("linear", 0.09f);
+		light.quadratic = jLight.value("quadratic", 0.032f);
+
+		light.location = getVec3(jLight.value("location", std::vector<float>{0.0f, 0.0f, 0.0f}));
+		light.direction = getVec3(jLight.value("direction", std::vector<float>{-0.5f, -1.0f, -0.3f}));
+
+		light.innerCutOff = jLight.value("innerCutOff", 0.97629600712f);
+		light.outerCutOff = jLight.value("outerCutOff", 0.95371695074f);
+
+		DATA.lights.push_back(light);
+	}
+	DATA.LightsChanged();
+
+	for (auto &jModel : jScene["Models"])
+	{
+		int shaderID = DATA.shadersManager.GetShaderID(jModel["vShader"].get<std::string>().c_str(), jModel["fShader"].get<std::string>().c_str());
+		Model *model = nullptr;
+		if (jModel.find("path") != jModel.end())
+		{
+			// SortFaces relies on the imported vertex and face order and edits the indices
+			ImportOptions options;
+			options.optimize = jModel.value("optimize", !jModel.value("transparentCube", false));
+			options.shared = !jModel.value("transparentCube", false);
+			options.keepCpuData = jModel.value("transparentCube", false);
+			options.batchStatic = jModel.value("batch", false) && !jModel.value("transparentCube", false);
+			const std::string path = jModel["path"].get<std::string>();
+			model = new Model(path, shaderID, nullptr);
+			loader.LoadModel(model, path, options);
+		}
+		else
+		{
+			// batched with every other quad, the -0.5..0.5 quad the scale used to apply to is implied
+			Quad quad;
+			quad.center = getVec3(jModel.value("location", std::vector<float>{0.f, 0.f, 0.f}));
+			const glm::vec3 scale = getVec3(jModel.value("scale", std::vector<float>{1.f, 1.f, 1.f}));
+			quad.size = {scale.x, scale.y};
+			quad.billboard = jModel.value("billboard", false);
+			quad.sprite = quads.AddSprite(jModel.value("texture", ""));
+			quad.name = jModel.value("name", jModel.value("texture", ""));
+			quad.shaderID = shaderID;
+			quad.color = glm::vec4{getVec3(jModel.value("color", std::vector<float>{0.f, 0.f, 0.f})), 1.f};
+			quad.opaque = jModel.value("opaque", false);
+			quad.solidColor = jModel.value("solidColor", false);
+			// outlines need a stencil pass per model
+			if (jModel.value("outline", false))
+				std::cerr << "ERROR::SCENE::QUAD_OUTLINE_UNSUPPORTED " << quad.name << std::endl;
+			quads.Add(quad);
+		}
+		if (!model)
+			continue;
+
+		model->SetLocation(getVec3(jModel.value("location", std::vector<float>{0.f, 0.f, 0.f})));
+		model->SetScale(getVec3(jModel.value("scale", std::vector<float>{1.f, 1.f, 1.f})));
+		model->color = glm::vec4{getVec3(jModel.value("color", std::vector<float>{0.f, 0.f, 0.f})), 1.f};
+		model->opaque = jModel.value("opaque", false);
+		model->solidColor = jModel.value("solidColor", false);
+		model->outline = jModel.value("outline", false);
+		if (jModel.find("name") != jModel.end())
+			model->ChangeName(jModel.value("name", ""));
+		model->transparentCube = jModel.value("transparentCube", false);
+		if (model->transparentCube)
+			model->SortFaces();
+		DATA.models.push_back(model);
+	}
 }
\ No newline at end of file
@@ -1,64 +1,329 @@
-#include "mesh.h"
-#include "shader.h"
-
-Mesh::Mesh(std::vector<Vertex> vertices_, std::vector<unsigned int> indices_, std::vector<Texture> textures_)
-    : vertices(vertices_)
-    , indices(indices_)
-    , textures(textures_)
-{
-    setupMesh();
-}
-
-void Mesh::setupMesh()
-{
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-    
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-
-    glBindVertexArray(0);
-}
-
-void Mesh::Draw(const Shader& shader)
-{
-    GLuint diffuseNr = 1;
-    GLuint specularNr = 1;
-    for(GLuint i = 0; i < textures.size(); ++i)
-    {
-        glActiveTexture(GL_TEXTURE0 + i);
-
-        std::string number;
-        std::string name = textures[i].type;
-        if (name == "texture_diffuse")
-            number = std::to_string(diffuseNr++);
-        else if(name == "texture_specular")
-            number = std::to_string(specularNr++);
-
-        shader.set(("material." + name + number).c_str(), (int)i);
-        glBindTexture(GL_TEXTURE_2D, textures[i].id);
-    }
-    glActiveTexture(GL_TEXTURE0);
-    
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
-
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-}
\ No newline at end of file
+#include "mesh.h"
+#include "shader.h"
+#include "GLState.h"
+#include "MemoryTracker.h"
+#include <iostream>
+#include <algorithm>
+#include <glm/gtc/packing.hpp>
+
+Mesh::Mesh(std::vector<Vertex> vertices_, std::vector<unsigned int> indices_, std::vector<Texture> textures_,
+           const std::vector<std::vector<GLuint>>& lodIndices/* = {}*/, const std::vector<float>& lodErrors/* = {}*/,
+           bool keepCpuData_/* = false*/)
+    : vertices(vertices_)
+    , indices(indices_)
+    , textures(textures_)
+    , keepCpuData(keepCpuData_)
+{
+    std::vector<char> vertexData;
+    std::vector<char> indexData;
+    setupMesh(BuildGeometry(vertices, indices, lodIndices, lodErrors, vertexData, indexData));
+    if (keepCpuData)
+    {
+        trackCpuData();
+    }
+    else
+    {
+        // only the GPU copy is drawn, swapping also frees the capacity
+        std::vector<Vertex>().swap(vertices);
+        std::vector<GLuint>().swap(indices);
+    }
+}
+
+Mesh::Mesh(const MeshGeometry& meshGeometry, std::vector<Texture> textures_,
+           std::vector<Vertex> cpuVertices/* = {}*/, std::vector<GLuint> cpuIndices/* = {}*/)
+    : vertices(std::move(cpuVertices))
+    , indices(std::move(cpuIndices))
+    , textures(textures_)
+    , keepCpuData(!vertices.empty())
+{
+    setupMesh(meshGeometry);
+    if (keepCpuData)
+        trackCpuData();
+}
+
+Mesh::~Mesh()
+{
+    GeometryArena::Free(geometry);
+    MemoryTracker::Untrack(MEMORY_MESH_CPU_DATA, this);
+}
+
+Mesh::Mesh(Mesh&& other) noexcept
+    : vertices(std::move(other.vertices))
+    , indices(std::move(other.indices))
+    , textures(std::move(other.textures))
+    , geometry(other.geometry)
+    , name(std::move(other.name))
+    , keepCpuData(other.keepCpuData)
+    , positionScale(other.positionScale)
+    , positionOffset(other.positionOffset)
+    , lods(std::move(other.lods))
+    , subMeshes(std::move(other.subMeshes))
+    , boundsMin(other.boundsMin)
+    , boundsMax(other.boundsMax)
+    , samplerUniforms(std::move(other.samplerUniforms))
+    , hasSpecularMap(other.hasSpecularMap)
+    , dirtyIndicesBegin(other.dirtyIndicesBegin)
+    , dirtyIndicesEnd(other.dirtyIndicesEnd)
+{
+    other.geometry = GeometryAllocation{};
+    MemoryTracker::Untrack(MEMORY_MESH_CPU_DATA, &other);
+    if (keepCpuData)
+        trackCpuData();
+}
+
+Mesh& Mesh::operator=(Mesh&& other) noexcept
+{
+    if (this != &other)
+    {
+        GeometryArena::Free(geometry);
+        MemoryTracker::Untrack(MEMORY_MESH_CPU_DATA, &other);
+        vertices = std::move(other.vertices);
+        indices = std::move(other.indices);
+        textures = std::move(other.textures);
+        geometry = other.geometry;
+        name = std::move(other.name);
+        keepCpuData = other.keepCpuData;
+        positionScale = other.positionScale;
+        positionOffset = other.positionOffset;
+        lods = std::move(other.lods);
+        subMeshes = std::move(other.subMeshes);
+        boundsMin = other.boundsMin;
+        boundsMax = other.boundsMax;
+        samplerUniforms = std::move(other.samplerUniforms);
+        hasSpecularMap = other.hasSpecularMap;
+        dirtyIndicesBegin = other.dirtyIndicesBegin;
+        dirtyIndicesEnd = other.dirtyIndicesEnd;
+        other.geometry = GeometryAllocation{};
+        if (keepCpuData)
+            trackCpuData();
+        else
+            MemoryTracker::Untrack(MEMORY_MESH_CPU_DATA, this);
+    }
+    return *this;
+}
+
+MeshGeometry Mesh::BuildGeometry(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices,
+                                 const std::vector<std::vector<GLuint>>& lodIndices, const std::vector<float>& lodErrors,
+                                 std::vector<char>& vertexData, std::vector<char>& indexData)
+{
+    MeshGeometry geometry;
+    for(size_t i = 0; i < vertices.size(); ++i)
+    {
+        geometry.boundsMin = i ? glm::min(geometry.boundsMin, vertices[i].Position) : vertices[i].Position;
+        geometry.boundsMax = i ? glm::max(geometry.boundsMax, vertices[i].Position) : vertices[i].Position;
+    }
+
+    // every level lives in the same index allocation, one after the other
+    geometry.lods.push_back(MeshLod{0, (GLsizei)indices.size(), 0.f});
+    std::vector<GLuint> allIndices = indices;
+    for(size_t level = 0; level < lodIndices.size(); ++level)
+    {
+        geometry.lods.push_back(MeshLod{(GLsizei)allIndices.size(), (GLsizei)lodIndices[level].size(), level < lodErrors.size() ? lodErrors[level] : 0.f});
+        allIndices.insert(allIndices.end(), lodIndices[level].begin(), lodIndices[level].end());
+    }
+
+    std::vector<PackedVertex> packed;
+    if (packVertices(vertices, packed, geometry.positionScale, geometry.positionOffset))
+    {
+        geometry.format = VERTEX_FORMAT_PACKED;
+        vertexData.assign((const char*)packed.data(), (const char*)(packed.data() + packed.size()));
+    }
+    else
+    {
+        geometry.format = VERTEX_FORMAT_DEFAULT;
+        geometry.positionScale = glm::vec3{1.f};
+        geometry.positionOffset = glm::vec3{0.f};
+        vertexData.assign((const char*)vertices.data(), (const char*)(vertices.data() + vertices.size()));
+    }
+    geometry.vertexCount = (GLsizei)vertices.size();
+
+    geometry.indexCount = (GLsizei)allIndices.size();
+    if (GeometryArena::IndexType(geometry.vertexCount) == GL_UNSIGNED_SHORT)
+    {
+        std::vector<GLushort> narrowed(allIndices.begin(), allIndices.end());
+        indexData.assign((const char*)narrowed.data(), (const char*)(narrowed.data() + narrowed.size()));
+    }
+    else
+    {
+        indexData.assign((const char*)allIndices.data(), (const char*)(allIndices.data() + allIndices.size()));
+    }
+
+    geometry.vertices = vertexData.data();
+    geometry.indices = indexData.data();
+    return geometry;
+}
+
+void Mesh::setupMesh(const MeshGeometry& meshGeometry)
+{
+    boundsMin = meshGeometry.boundsMin;
+    boundsMax = meshGeometry.boundsMax;
+    positionScale = meshGeometry.positionScale;
+    positionOffset = meshGeometry.positionOffset;
+    lods = meshGeometry.lods;
+    subMeshes = meshGeometry.subMeshes;
+    geometry = GeometryArena::Allocate(meshGeometry.format, meshGeometry.vertices, meshGeometry.vertexCount, meshGeometry.indices, meshGeometry.indexCount);
+
+    int diffuseNr = 0;
+    int specularNr = 0;
+    for(const Texture& texture : textures)
+    {
+        const UniformName* sampler = nullptr;
+        if (texture.type == "texture_diffuse" && diffuseNr < Uniforms::MAX_SAMPLERS_PER_TYPE)
+            sampler = &Uniforms::diffuseSamplers[diffuseNr++];
+        else if (texture.type == "texture_specular" && specularNr < Uniforms::MAX_SAMPLERS_PER_TYPE)
+            sampler = &Uniforms::specularSamplers[specularNr++];
+        else
+            std::cerr << "ERROR::MESH::UNSUPPORTED_TEXTURE " << texture.type << " " << texture.path << std::endl;
+        samplerUniforms.push_back(sampler);
+    }
+    hasSpecularMap = specularNr > 0;
+}
+
+// Quantizes every vertex and checks the decoded values against the originals.
+// Returns false, and the mesh stays in full precision, if any of them is off by more than the tolerance.
+bool Mesh::packVertices(const std::vector<Vertex>& vertices, std::vector<PackedVertex>& packed, glm::vec3& scale, glm::vec3& offset)
+{
+    const float POSITION_TOLERANCE = 1e-4f; // relative to the bounds diagonal
+    const float NORMAL_TOLERANCE = 0.9998f; // cosine, about 1 degree
+    const float TEX_COORDS_TOLERANCE = 1.f / 1024.f;
+
+    if (vertices.empty())
+        return false;
+
+    glm::vec3 minPos = vertices[0].Position;
+    glm::vec3 maxPos = vertices[0].Position;
+    for(const Vertex& vertex : vertices)
+    {
+        minPos = glm::min(minPos, vertex.Position);
+        maxPos = glm::max(maxPos, vertex.Position);
+    }
+    glm::vec3 extent = maxPos - minPos;
+    // flat meshes still need a non zero scale on their flat axis
+    for(int axis = 0; axis < 3; ++axis)
+        if (extent[axis] <= 0.f)
+            extent[axis] = 1.f;
+    const float maxPositionError = POSITION_TOLERANCE * glm::length(maxPos - minPos);
+
+    packed.resize(vertices.size());
+    for(size_t i = 0; i < vertices.size(); ++i)
+    {
+        const Vertex& vertex = vertices[i];
+        PackedVertex& out = packed[i];
+
+        const glm::vec3 normalized = glm::clamp((vertex.Position - minPos) / extent, 0.f, 1.f);
+        const glm::uvec3 quantized = glm::uvec3(glm::round(normalized * 65535.f));
+        for(int axis = 0; axis < 3; ++axis)
+            out.Position[axis] = (GLushort)quantized[axis];
+        out.Position[3] = 0;
+        const glm::vec3 decodedPosition = glm::vec3(quantized) / 65535.f * extent + minPos;
+        if (glm::any(glm::greaterThan(glm::abs(decodedPosition - vertex.Position), glm::vec3(maxPositionError))))
+            return false;
+
+        out.Normal = glm::packSnorm3x10_1x2(glm::vec4(vertex.Normal, 0.f));
+        const float normalLength = glm::length(vertex.Normal);
+        if (normalLength > 0.f)
+        {
+            const glm::vec3 decodedNormal = glm::vec3(glm::unpackSnorm3x10_1x2(out.Normal));
+            if (glm::length(decodedNormal) <= 0.f || glm::dot(glm::normalize(decodedNormal), vertex.Normal / normalLength) < NORMAL_TOLERANCE)
+                return false;
+        }
+
+        const GLuint texCoords = glm::packHalf2x16(vertex.TexCoords);
+        out.TexCoords[0] = GLushort(texCoords & 0xFFFF);
+        out.TexCoords[1] = GLushort(texCoords >> 16);
+        const glm::vec2 decodedTexCoords = glm::unpackHalf2x16(texCoords);
+        if (glm::any(glm::greaterThan(glm::abs(decodedTexCoords - vertex.TexCoords), glm::vec2(TEX_COORDS_TOLERANCE))))
+            return false;
+    }
+
+    scale = extent;
+    offset = minPos;
+    return true;
+}
+
+void Mesh::Draw(const Shader& shader, int lod/* = 0*/)
+{
+    bind(shader);
+    const MeshLod& level = GetLod(lod);
+    GeometryArena::Draw(geometry, level.firstIndex, level.indexCount);
+}
+
+void Mesh::DrawInstanced(const Shader& shader, int lod, GLsizei instanceCount)
+{
+    bind(shader);
+    const MeshLod& level = GetLod(lod);
+    GeometryArena::DrawInstanced(geometry, level.firstIndex, level.indexCount, instanceCount);
+}
+
+void Mesh::bind(const Shader& shader)
+{
+    for(GLuint i = 0; i < textures.size(); ++i)
+    {
+        if (!samplerUniforms[i])
+            continue;
+        // specialized variants drop samplers they don't read, nothing to bind then
+        UniformHandle sampler = shader.GetUniform(*samplerUniforms[i]);
+        if (!sampler.IsValid())
+            continue;
+        GLState::ActiveTexture(GL_TEXTURE0 + i);
+        shader.set(sampler, (int)i);
+        GLState::BindTexture(GL_TEXTURE_2D, textures[i].id);
+    }
+    GLState::ActiveTexture(GL_TEXTURE0);
+
+    shader.set(Uniforms::meshPositionScale, positionScale);
+    shader.set(Uniforms::meshPositionOffset, positionOffset);
+    uploadDirtyIndices();
+}
+
+void Mesh::MarkIndicesDirty(size_t first, size_t count)
+{
+    if (count == 0)
+        return;
+    if (dirtyIndicesBegin == dirtyIndicesEnd)
+    {
+        dirtyIndicesBegin = first;
+        dirtyIndicesEnd = first + count;
+        return;
+    }
+    dirtyIndicesBegin = std::min(dirtyIndicesBegin, first);
+    dirtyIndicesEnd = std::max(dirtyIndicesEnd, first + count);
+}
+
+void Mesh::SetName(const std::string& name_)
+{
+    name = name_;
+    if (keepCpuData)
+        trackCpuData();
+}
+
+void Mesh::trackCpuData()
+{
+    MemoryTracker::Track(MEMORY_MESH_CPU_DATA, this, name.empty() ? "unnamed mesh" : name,
+                         vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(GLuint));
+}
+
+void Mesh::uploadDirtyIndices()
+{
+    if (!keepCpuData)
+        return;
+    if (dirtyIndicesBegin == dirtyIndicesEnd && (GLsizei)indices.size() == lods[0].indexCount)
+        return;
+
+    if ((GLsizei)indices.size() != lods[0].indexCount)
+    {
+        // coarser levels were built from the old indices
+        lods.resize(1);
+        lods[0].indexCount = (GLsizei)indices.size();
+        GeometryArena::ReplaceIndices(geometry, indices.data(), (GLsizei)indices.size());
+    }
+    else
+    {
+        // the range may have been marked past the end before the indices shrank back
+        const size_t begin = std::min(dirtyIndicesBegin, indices.size());
+        const size_t end = std::min(dirtyIndicesEnd, indices.size());
+        if (begin < end)
+            GeometryArena::UpdateIndices(geometry, (GLsizei)begin, GLsizei(end - begin), &indices[begin]);
+    }
+    dirtyIndicesBegin = dirtyIndicesEnd = 0;
+}
@@ -1,36 +1,138 @@
-#pragma once
-
-#include <glad/glad.h>
-#include <glm/glm.hpp>
-#include <string>
-#include <vector>
-
-struct Vertex
-{
-    glm::vec3 Position;
-    glm::vec3 Normal;
-    glm::vec2 TexCoords;
-};
-
-struct Texture
-{
-    GLuint id;
-    std::string type;
-    std::string path;
-};
-
-class Mesh
-{
-public:
-    std::vector<Vertex> vertices;
-    std::vector<GLuint> indices;
-    std::vector<Texture> textures;
-
-    Mesh(std::vector<Vertex> vertices, std::vector<GLuint> indices, std::vector<Texture> textures);
-    void Draw(const class Shader& shader);
-
-private:
-    GLuint VAO, VBO, EBO;
-
-    void setupMesh();
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#include "uniforms.h"
+#include "GeometryArena.h"
+
+struct Vertex
+{
+    glm::vec3 Position;
+    glm::vec3 Normal;
+    glm::vec2 TexCoords;
+};
+
+// 16 bytes instead of 32: positions normalized to the mesh bounds, normals as
+// GL_INT_2_10_10_10_REV, texture coordinates as half floats
+struct PackedVertex
+{
+    GLushort Position[4]; // w unused, keeps Normal aligned
+    GLuint Normal;
+    GLushort TexCoords[2];
+};
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay tightly packed");
+
+struct TextureAsset;
+
+struct Texture
+{
+    GLuint id;
+    std::string type;
+    std::string path;
+    std::shared_ptr<TextureAsset> asset; // keeps id alive, see AssetRegistry
+};
+
+// A range of the mesh's indices, level 0 is `indices` itself
+struct MeshLod
+{
+    GLsizei firstIndex = 0;
+    GLsizei indexCount = 0;
+    float error = 0.f; // relative to the mesh size, see MeshOptimizer::Simplify
+};
+
+// Where one source mesh ended up in a batched mesh's first level, kept for picking
+struct SubMesh
+{
+    std::string name;
+    GLsizei firstIndex = 0;
+    GLsizei indexCount = 0;
+    glm::vec3 boundsMin{0.f};
+    glm::vec3 boundsMax{0.f};
+};
+
+// Vertices and indices of every level in the layout they have in the geometry arena,
+// see Mesh::BuildGeometry. Only points to the data, which must outlive the mesh's construction.
+struct MeshGeometry
+{
+    VertexFormat format = VERTEX_FORMAT_DEFAULT;
+    const void* vertices = nullptr;
+    GLsizei vertexCount = 0;
+    const void* indices = nullptr; // of GeometryArena::IndexType(vertexCount), levels one after the other
+    GLsizei indexCount = 0;
+    glm::vec3 positionScale{1.f};
+    glm::vec3 positionOffset{0.f};
+    glm::vec3 boundsMin{0.f};
+    glm::vec3 boundsMax{0.f};
+    std::vector<MeshLod> lods;
+    std::vector<SubMesh> subMeshes; // empty unless several meshes were batched into this one
+};
+
+class Mesh
+{
+public:
+    // empty once uploaded, unless the mesh was created keeping its CPU data
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    std::vector<Texture> textures;
+
+    // lodIndices are coarser levels over the same vertices, finest first
+    Mesh(std::vector<Vertex> vertices, std::vector<GLuint> indices, std::vector<Texture> textures,
+         const std::vector<std::vector<GLuint>>& lodIndices = {}, const std::vector<float>& lodErrors = {},
+         bool keepCpuData = false);
+    // Uploads geometry that is already in the arena layout, e.g. mapped from a baked file.
+    // The CPU data is kept if given, it must match the geometry's first level.
+    Mesh(const MeshGeometry& geometry, std::vector<Texture> textures,
+         std::vector<Vertex> cpuVertices = {}, std::vector<GLuint> cpuIndices = {});
+    ~Mesh();
+    // owns its range of the geometry arena
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+    Mesh(Mesh&& other) noexcept;
+    Mesh& operator=(Mesh&& other) noexcept;
+
+    void Draw(const class Shader& shader, int lod = 0);
+    // Per-instance data must be uploaded first, see GeometryArena::UploadInstances
+    void DrawInstanced(const class Shader& shader, int lod, GLsizei instanceCount);
+    bool HasSpecularMap() const { return hasSpecularMap; }
+    bool HasCpuData() const { return keepCpuData; }
+    // Packs the vertices if precise enough and narrows the indices, the result points into vertexData and indexData
+    static MeshGeometry BuildGeometry(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices,
+                                      const std::vector<std::vector<GLuint>>& lodIndices, const std::vector<float>& lodErrors,
+                                      std::vector<char>& vertexData, std::vector<char>& indexData);
+    // label of the mesh in the memory stats
+    void SetName(const std::string& name);
+    int LodCount() const { return (int)lods.size(); }
+    const MeshLod& GetLod(int lod) const { return lods[std::min(lod, LodCount() - 1)]; }
+    const glm::vec3& GetBoundsMin() const { return boundsMin; }
+    const glm::vec3& GetBoundsMax() const { return boundsMax; }
+    const std::vector<SubMesh>& GetSubMeshes() const { return subMeshes; }
+    // Call after editing `indices`, the range is uploaded on the next Draw. Needs the CPU data.
+    void MarkIndicesDirty(size_t first, size_t count);
+
+private:
+    GeometryAllocation geometry;
+    std::string name;
+    bool keepCpuData = false;
+    // maps packed positions back to mesh space, identity for unpacked meshes
+    glm::vec3 positionScale{1.f};
+    glm::vec3 positionOffset{0.f};
+    std::vector<MeshLod> lods;
+    std::vector<SubMesh> subMeshes;
+    glm::vec3 boundsMin{0.f};
+    glm::vec3 boundsMax{0.f};
+    std::vector<const UniformName*> samplerUniforms; // per texture, nullptr if the type isn't sampled
+    bool hasSpecularMap = false;
+    size_t dirtyIndicesBegin = 0;
+    size_t dirtyIndicesEnd = 0; // empty range when equal to begin
+
+    void setupMesh(const MeshGeometry& meshGeometry);
+    static bool packVertices(const std::vector<Vertex>& vertices, std::vector<PackedVertex>& packed, glm::vec3& scale, glm::vec3& offset);
+    void uploadDirtyIndices();
+    void trackCpuData();
+    void bind(const class Shader& shader);
 };
\ No newline at end of file
@@ -1,316 +1,668 @@
-#include "model.h"
-#include "mesh.h"
-#include "shader.h"
-#include "stb_image.h"
-#include "globalData.h"
-#include <glm/gtc/matrix_transform.hpp>
-
-int Model::NEXT_ID = 0;
-
-void Model::SetLocation(const glm::vec3& location)
-{
-    this->location = location;
-    if (transparentCube)
-        SortFaces();
-}
-
-void Model::SetScale(const glm::vec3& scale)
-{
-    this->scale = scale;
-    if (transparentCube)
-        SortFaces();
-}
-
-void Model::SetRotation(const glm::vec3& rotation)
-{
-    this->rotation = rotation;
-    if (transparentCube)
-        SortFaces();
-}
-
-Model::Model(const Mesh& mesh, int shaderId, glm::vec3 location_/* = {0.f, 0.f, 0.f}*/, glm::vec3 scale_/* = {1.f, 1.f, 1.f}*/, glm::vec3 rotation_/* = {0.f, 0.f, 0.f}*/)
-    : location(location_)
-    , scale(scale_)
-    , rotation(rotation_)
-    , shaderID(shaderId)
-    , ID(NEXT_ID++)
-{
-    meshes.push_back(std::move(mesh));
-
-    name = std::to_string(ID) + "_";
-}
-
-void Model::Draw(Shader& shader)
-{
-    for(GLuint i = 0; i < meshes.size(); ++i)
-        meshes[i].Draw(shader);
-}
-
-void Model::DrawPointLight()
-{
-    Shader& shader = DATA.shadersManager.GetShader(shaderID);
-    shader.use();
-    shader.set("color", color);
-
-    modelMat = glm::mat4{1.f};
-    modelMat = glm::translate(modelMat, location);
-    modelMat = glm::scale(modelMat, scale);
-    modelMat = glm::rotate(modelMat, glm::radians(rotation.x), glm::vec3(1.f, 0.0f, 0.0f));
-    modelMat = glm::rotate(modelMat, glm::radians(rotation.y), glm::vec3(0.f, 1.0f, 0.0f));
-    modelMat = glm::rotate(modelMat, glm::radians(rotation.z), glm::vec3(0.f, 0.0f, 1.0f));
-    shader.set("model", modelMat);
-
-    Draw(shader);
-}
-
-void Model::DrawSpotLight(float angle, glm::vec3 axis)
-{
-    Shader& shader = DATA.shadersManager.GetShader(shaderID);
-    shader.use();
-    shader.set("color", color);
-
-    modelMat = glm::mat4{1.f};
-    modelMat = glm::translate(modelMat, location);
-    modelMat = glm::scale(modelMat, scale);
-    modelMat = glm::rotate(modelMat, angle, axis);
-    shader.set("model", modelMat);
-
-    Draw(shader);
-}
-
-void Model::DrawModel()
-{
-    Shader& shader = DATA.shadersManager.GetShader(shaderID);
-    shader.use();
-    shader.set("isSolidColor", solidColor);
-    shader.set("color", color);
-    shader.set("material.shininess", shininess);
-    shader.set("opaque", opaque);
-
-    modelMat = glm::mat4{1.f};
-    modelMat = glm::translate(modelMat, location);
-    modelMat = glm::scale(modelMat, scale);
-    modelMat = glm::rotate(modelMat, glm::radians(rotation.x), glm::vec3(1.f, 0.0f, 0.0f));
-    modelMat = glm::rotate(modelMat, glm::radians(rotation.y), glm::vec3(0.f, 1.0f, 0.0f));
-    modelMat = glm::rotate(modelMat, glm::radians(rotation.z), glm::vec3(0.f, 0.0f, 1.0f));
-    shader.set("model", modelMat);
-
-    Draw(shader);
-}
-
-void Model::loadModel(std::string path)
-{
-    Assimp::Importer import;
-    const aiScene *scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals);
-
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
-    {
-        std::cerr << "ERROR::ASSIMP::" << import.GetErrorString() << std::endl;
-        return;
-    }
-
-    directory = path.substr(0, path.find_last_of('/'));
-
-    processNode(scene->mRootNode, scene);
-}
-
-void Model::processNode(aiNode *node, const aiScene *scene)
-{
-    glm::mat3 scaleMat{1.f};
-    for(int i = 0; i < 3; ++i)
-    {
-        if (node->mTransformation[i][i] != 1.f)
-        {
-            scaleMat[i][i] = node->mTransformation[i][i];
-        }
-    }
-    for(GLuint i = 0; i < node->mNumMeshes; ++i)
-    {
-        aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(processMesh(mesh, scene, scaleMat));
-    }
-
-    for(GLuint i = 0; i < node->mNumChildren; ++i)
-    {
-        processNode(node->mChildren[i], scene);
-    }
-}
-
-Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene, glm::mat3 scale/* = glm::mat3{1.f}*/)
-{
-    std::vector<Vertex> vertices;
-    std::vector<GLuint> indices;
-    std::vector<Texture> textures;
-
-    for(GLuint i = 0; i < mesh->mNumVertices; ++i)
-    {
-        Vertex vertex;
-
-        vertex.Position = {mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z};
-        vertex.Position = scale * vertex.Position;
-        vertex.Normal = {mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z};
-        if (mesh->mTextureCoords[0])
-            vertex.TexCoords = {mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y};
-        else
-            vertex.TexCoords = {0.f, 0.f};
-        
-        vertices.push_back(vertex);
-    }
-    
-    for(GLuint i = 0; i < mesh->mNumFaces; ++i)
-    {
-        const aiFace& face = mesh->mFaces[i];
-        for(GLuint j = 0; j < face.mNumIndices; ++j)
-            indices.push_back(face.mIndices[j]);
-    }
-
-    if (mesh->mMaterialIndex >= 0)
-    {
-        aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
-        std::vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-        std::vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-    }
-
-    return Mesh(vertices, indices, textures);
-}
-
-std::vector<Texture> Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName)
-{
-    std::vector<Texture> textures;
-    for(GLuint i = 0; i < mat->GetTextureCount(type); ++i)
-    {
-        aiString str;
-        mat->GetTexture(type, i, &str);
-        bool skip = false;
-        for(GLuint j = 0; j < textures_loaded.size() && !skip; ++j)
-        {
-            if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-            {
-                textures.push_back(textures_loaded[j]);
-                skip = true;
-            }
-        }
-        if (!skip)
-        {
-            Texture texture;
-            texture.id = TextureFromFile(str.C_Str(), directory);
-            texture.type = typeName;
-            texture.path = str.C_Str();
-            textures.push_back(texture);
-            textures_loaded.push_back(texture);
-        }
-    }
-
-    return textures;
-}
-
-void Model::ChangeName(const std::string& newName)
-{
-    name = std::to_string(ID) + '_' + newName;
-}
-
-GLuint TextureFromFile(const char *path, const std::string& directory, bool gamma/* = false*/)
-{
-    std::string filename(path);
-    if (!directory.empty())
-        filename = directory + '/' + filename;
-
-	GLuint textureID;
-	glGenTextures(1, &textureID);
-
-	int width, height, nrComponents;
-	GLubyte *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (!data)
-    {
-        filename = path;
-        filename = "textures/" + filename;
-        data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    }
-	if (data)
-	{
-		GLenum format;
-		if (nrComponents == 1)
-			format = GL_RED;
-		else if (nrComponents == 3)
-			format = GL_RGB;
-		else if (nrComponents == 4)
-			format = GL_RGBA;
-
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		stbi_image_free(data);
-	}
-	else
-	{
-		std::cerr << "Texture failed to load at path: " << filename.c_str() << std::endl;
-		stbi_image_free(data);
-	}
-
-	return textureID;
-}
-
-GLuint CubemapFromFile(const std::vector<std::string> &faces)
-{
-    GLuint texID;
-    glGenTextures(1, &texID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texID);
-
-    int width, height, nrChannels;
-    for(GLuint i = 0; i < faces.size(); ++i)
-    {
-        GLubyte *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-        if (data)
-        {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        }
-        else
-        {
-            std::cerr << "Cubemap tex failed to load at path: " << faces[i] << std::endl;
-        }
-        stbi_image_free(data);
-    }
-
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    return texID;
-}
-
-void Model::SortFaces()
-{
-    Mesh& cubeMesh = meshes[0];
-    const size_t facesCount = 6;
-    const size_t faceIndicesCount = cubeMesh.indices.size() / facesCount;
-    std::vector<std::pair<bool, size_t>> sortedFaces;
-    for(size_t face = 0; face < facesCount; ++face)
-    {
-        const size_t firstIndexOfFace = face*facesCount;
-        const glm::vec3 faceNorm = glm::mat3(glm::transpose(glm::inverse(modelMat))) * cubeMesh.vertices[firstIndexOfFace].Normal;
-        const glm::vec3 vertexWorldPosition = glm::vec3{modelMat * glm::vec4{cubeMesh.vertices[firstIndexOfFace].Position, 1.f}};
-        const glm::vec3 dirToCam = glm::normalize(DATA.camera.Position - vertexWorldPosition);
-        bool lookToCam = glm::dot(faceNorm, dirToCam) >= 0.f;
-        sortedFaces.emplace_back(lookToCam, face);
-    }
-    std::sort(sortedFaces.begin(), sortedFaces.end(), [](const std::pair<bool, size_t>& p1, const std::pair<bool, size_t>& p2) {
-        return p1.first < p2.first;
-    });
-
-    cubeMesh.indices.clear();
-    for(auto& p : sortedFaces)
-    {
-        for(size_t i = 0; i < faceIndicesCount; ++i)
-            cubeMesh.indices.push_back(GLuint(p.second * faceIndicesCount + i));
-    }
+#include "model.h"
+#include "mesh.h"
+#include "shader.h"
+#include "stb_image.h"
+#include "globalData.h"
+#include "GLState.h"
+#include "MemoryTracker.h"
+#include "TextureStreamer.h"
+#include "TextureCache.h"
+#include "TextureCompressor.h"
+#include "MappedIOSystem.h"
+#include "Hash.h"
+#include "Trace.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <map>
+
+int Model::NEXT_ID = 0;
+
+namespace
+{
+    const size_t MIN_LOD_TRIANGLES = 256; // smaller meshes aren't worth the extra levels
+    const float LOD_TRIANGLES_RATIO = 0.5f;
+    const float LOD_MAX_ERROR[Model::MAX_LODS] = {0.f, 0.01f, 0.02f, 0.04f};
+    // share of the screen height covered by the bounding sphere under which the next level is used
+    const float LOD_SCREEN_SIZES[Model::MAX_LODS - 1] = {0.5f, 0.25f, 0.125f};
+    const float LOD_HYSTERESIS = 0.15f;
+}
+
+void Model::SetLocation(const glm::vec3& location)
+{
+    this->location = location;
+    if (transparentCube)
+        SortFaces();
+}
+
+void Model::SetScale(const glm::vec3& scale)
+{
+    this->scale = scale;
+    if (transparentCube)
+        SortFaces();
+}
+
+void Model::SetRotation(const glm::vec3& rotation)
+{
+    this->rotation = rotation;
+    if (transparentCube)
+        SortFaces();
+}
+
+Model::Model(std::shared_ptr<Mesh> mesh, int shaderId, glm::vec3 location_/* = {0.f, 0.f, 0.f}*/, glm::vec3 scale_/* = {1.f, 1.f, 1.f}*/, glm::vec3 rotation_/* = {0.f, 0.f, 0.f}*/)
+    : location(location_)
+    , scale(scale_)
+    , rotation(rotation_)
+    , shaderID(shaderId)
+    , ID(NEXT_ID++)
+{
+    meshes.push_back(std::move(mesh));
+    computeBounds();
+
+    name = std::to_string(ID) + "_";
+}
+
+void Model::Draw(Shader& shader, int lod/* = 0*/)
+{
+    for(GLuint i = 0; i < meshes.size(); ++i)
+        meshes[i]->Draw(shader, lod);
+}
+
+int Model::LodCount() const
+{
+    int count = 1;
+    for(const auto& mesh : meshes)
+        count = std::max(count, mesh->LodCount());
+    return count;
+}
+
+size_t Model::LodTrianglesCount(int lod) const
+{
+    size_t triangles = 0;
+    for(const auto& mesh : meshes)
+        triangles += mesh->GetLod(lod).indexCount / 3;
+    return triangles;
+}
+
+void Model::computeBounds()
+{
+    if (meshes.empty())
+        return;
+    glm::vec3 boundsMin = meshes[0]->GetBoundsMin();
+    glm::vec3 boundsMax = meshes[0]->GetBoundsMax();
+    for(const auto& mesh : meshes)
+    {
+        boundsMin = glm::min(boundsMin, mesh->GetBoundsMin());
+        boundsMax = glm::max(boundsMax, mesh->GetBoundsMax());
+    }
+    boundsCenter = (boundsMin + boundsMax) * 0.5f;
+    boundsRadius = glm::length(boundsMax - boundsMin) * 0.5f;
+}
+
+// Expects modelMat to be up to date
+int Model::selectLod()
+{
+    const int lodCount = LodCount();
+    if (lodCount <= 1)
+        return currentLod = 0;
+
+    const glm::vec3 center = glm::vec3(modelMat * glm::vec4(boundsCenter, 1.f));
+    const glm::vec3 absScale = glm::abs(scale);
+    const float radius = boundsRadius * std::max(absScale.x, std::max(absScale.y, absScale.z));
+    const float distance = glm::length(DATA.camera.Position - center);
+    if (distance <= radius)
+        return currentLod = 0;
+    const float screenSize = radius / (distance * std::tan(glm::radians(DATA.camera.Zoom) * 0.5f));
+
+    // a level is only left once the size is clearly past its threshold, so that it doesn't flicker at the boundary
+    int lod = std::min(currentLod, lodCount - 1);
+    while (lod > 0 && screenSize > LOD_SCREEN_SIZES[lod - 1] * (1.f + LOD_HYSTERESIS))
+        --lod;
+    while (lod < lodCount - 1 && screenSize < LOD_SCREEN_SIZES[lod] * (1.f - LOD_HYSTERESIS))
+        ++lod;
+    return currentLod = lod;
+}
+
+void Model::DrawPointLight()
+{
+    Shader& shader = DATA.shadersManager.GetShader(shaderID);
+    if (!shader.IsReady())
+        return;
+    shader.use();
+    shader.set(Uniforms::color, color);
+
+    modelMat = glm::mat4{1.f};
+    modelMat = glm::translate(modelMat, location);
+    modelMat = glm::scale(modelMat, scale);
+    modelMat = glm::rotate(modelMat, glm::radians(rotation.x), glm::vec3(1.f, 0.0f, 0.0f));
+    modelMat = glm::rotate(modelMat, glm::radians(rotation.y), glm::vec3(0.f, 1.0f, 0.0f));
+    modelMat = glm::rotate(modelMat, glm::radians(rotation.z), glm::vec3(0.f, 0.0f, 1.0f));
+    shader.set(Uniforms::model, modelMat);
+
+    Draw(shader);
+}
+
+void Model::DrawSpotLight(float angle, glm::vec3 axis)
+{
+    Shader& shader = DATA.shadersManager.GetShader(shaderID);
+    if (!shader.IsReady())
+        return;
+    shader.use();
+    shader.set(Uniforms::color, color);
+
+    modelMat = glm::mat4{1.f};
+    modelMat = glm::translate(modelMat, location);
+    modelMat = glm::scale(modelMat, scale);
+    modelMat = glm::rotate(modelMat, angle, axis);
+    shader.set(Uniforms::model, modelMat);
+
+    Draw(shader);
+}
+
+void Model::updateModelMatrix()
+{
+    modelMat = glm::mat4{1.f};
+    modelMat = glm::translate(modelMat, location);
+    modelMat = glm::scale(modelMat, scale);
+    modelMat = glm::rotate(modelMat, glm::radians(rotation.x), glm::vec3(1.f, 0.0f, 0.0f));
+    modelMat = glm::rotate(modelMat, glm::radians(rotation.y), glm::vec3(0.f, 1.0f, 0.0f));
+    modelMat = glm::rotate(modelMat, glm::radians(rotation.z), glm::vec3(0.f, 0.0f, 1.0f));
+}
+
+void Model::DrawModel()
+{
+    updateModelMatrix();
+
+    Shader& baseShader = DATA.shadersManager.GetShader(shaderID);
+    if (!baseShader.IsReady())
+        return;
+    const int lod = selectLod();
+    if (!baseShader.permutable)
+    {
+        baseShader.use();
+        setModelUniforms(baseShader);
+        Draw(baseShader, lod);
+        return;
+    }
+
+    ShaderPermutation permutation;
+    permutation.solidColor = solidColor;
+    permutation.opaque = opaque;
+    permutation.dirLights = DATA.dirLightsCount;
+    permutation.pointLights = DATA.pointLightsCount;
+    permutation.spotLights = DATA.spotLightsCount;
+
+    // meshes may differ in their maps, so the variant is picked per mesh
+    const Shader* current = nullptr;
+    for(auto& mesh : meshes)
+    {
+        permutation.specularMap = !solidColor && mesh->HasSpecularMap();
+        Shader* shader = &DATA.shadersManager.GetShader(DATA.shadersManager.GetVariant(shaderID, permutation));
+        // the generic program covers every permutation until the variant is compiled
+        if (!shader->IsReady())
+            shader = &baseShader;
+        if (shader != current)
+        {
+            shader->use();
+            setModelUniforms(*shader);
+            current = shader;
+        }
+        mesh->Draw(*shader, lod);
+    }
+}
+
+bool Model::CanInstanceWith(const Model& other) const
+{
+    // outlines are drawn per model and SortFaces edits the mesh itself
+    if (outline || other.outline || transparentCube || other.transparentCube)
+        return false;
+    return !meshes.empty() && meshes == other.meshes && shaderID == other.shaderID
+        && solidColor == other.solidColor && opaque == other.opaque;
+}
+
+bool Model::DrawInstanced(Model* const* models, size_t count)
+{
+    const Model& first = *models[0];
+    const Shader& baseShader = DATA.shadersManager.GetShader(first.shaderID);
+    // per-instance attributes only exist in specialized variants
+    if (!baseShader.IsReady() || !baseShader.permutable)
+        return false;
+
+    ShaderPermutation permutation;
+    permutation.solidColor = first.solidColor;
+    permutation.opaque = first.opaque;
+    permutation.dirLights = DATA.dirLightsCount;
+    permutation.pointLights = DATA.pointLightsCount;
+    permutation.spotLights = DATA.spotLightsCount;
+    permutation.instanced = true;
+
+    // all or nothing, the caller draws the group one by one otherwise
+    std::vector<Shader*> shaders;
+    for(const auto& mesh : first.meshes)
+    {
+        permutation.specularMap = !first.solidColor && mesh->HasSpecularMap();
+        Shader* shader = &DATA.shadersManager.GetShader(DATA.shadersManager.GetVariant(first.shaderID, permutation));
+        if (!shader->IsReady())
+            return false;
+        shaders.push_back(shader);
+    }
+
+    static std::vector<InstanceData> instances;
+    instances.clear();
+    int lod = MAX_LODS - 1;
+    for(size_t i = 0; i < count; ++i)
+    {
+        Model& model = *models[i];
+        model.updateModelMatrix();
+        // the group shares one level, the closest instance decides
+        lod = std::min(lod, model.selectLod());
+        instances.push_back({model.modelMat, model.color, glm::vec4{model.solidColor ? 1.f : 0.f, model.opaque ? 1.f : 0.f, model.shininess, 0.f}});
+    }
+    GeometryArena::UploadInstances(instances.data(), (GLsizei)instances.size());
+
+    const Shader* current = nullptr;
+    for(size_t i = 0; i < first.meshes.size(); ++i)
+    {
+        if (shaders[i] != current)
+        {
+            shaders[i]->use();
+            current = shaders[i];
+        }
+        first.meshes[i]->DrawInstanced(*shaders[i], lod, (GLsizei)count);
+    }
+    return true;
+}
+
+void Model::setModelUniforms(const Shader& shader)
+{
+    shader.set(Uniforms::isSolidColor, solidColor);
+    shader.set(Uniforms::color, color);
+    shader.set(Uniforms::shininess, shininess);
+    shader.set(Uniforms::opaque, opaque);
+    shader.set(Uniforms::model, modelMat);
+}
+
+void Model::SetAsset(std::shared_ptr<const ModelAsset> asset_)
+{
+    asset = std::move(asset_);
+    meshes = asset ? asset->meshes : std::vector<std::shared_ptr<Mesh>>{};
+    computeBounds();
+    if (transparentCube)
+        SortFaces();
+}
+
+std::shared_ptr<ModelAsset> Model::Import(const std::string& path, const ImportOptions& options)
+{
+    std::unique_ptr<ImportedModel> imported = Read(path, options);
+    auto asset = std::make_shared<ModelAsset>();
+    asset->directory = imported->directory;
+    for(size_t i = 0; i < imported->meshes.size(); ++i)
+        asset->meshes.push_back(UploadMesh(*imported, i));
+    return asset;
+}
+
+std::unique_ptr<ImportedModel> Model::Read(const std::string& path, const ImportOptions& options)
+{
+    TraceScope trace("model", "Read " + path);
+    auto imported = std::make_unique<ImportedModel>();
+    imported->directory = path.substr(0, path.find_last_of('/'));
+
+    // meshes edited on the CPU keep being built from their vertices
+    const uint64_t sourceHash = options.keepCpuData || MeshCache::cacheDirectory.empty() ? 0 : MeshCache::SourceHash(path);
+    const std::string cachePath = sourceHash ? MeshCache::CachePath(path, options) : "";
+    if (!sourceHash || !MeshCache::Read(cachePath, sourceHash, *imported))
+    {
+        Assimp::Importer import;
+        // owned by the importer
+        MappedIOSystem *io = new MappedIOSystem;
+        import.SetIOHandler(io);
+        const double importStart = Trace::Now();
+        const aiScene *scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals);
+        const double importEnd = Trace::Now();
+        Trace::Record("model", "Assimp " + path, importStart, importEnd);
+        const double importSeconds = (importEnd - importStart) / 1e6;
+        const AssimpIOStats &ioStats = io->Stats();
+        std::cout << "Import " << path << ": " << importSeconds * 1000.0 << " ms, I/O " << ioStats.readSeconds * 1000.0 << " ms, "
+                  << ioStats.filesOpened << " files opened (" << ioStats.filesMapped << " mapped, " << ioStats.cacheHits << " cache hits), "
+                  << ioStats.bytesRead << " bytes in " << ioStats.readCalls << " reads, " << ioStats.syscalls << " syscalls" << std::endl;
+
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        {
+            std::cerr << "ERROR::ASSIMP::" << import.GetErrorString() << std::endl;
+            return imported;
+        }
+
+        TraceScope buildTrace("model", "Build meshes " + path);
+        MeshOptimizationReport report;
+        std::vector<ImportedMeshPart> parts;
+        processNode(scene->mRootNode, scene, options, imported->directory, glm::mat4{1.f}, parts, report);
+        if (options.batchStatic)
+            imported->meshes = batchParts(std::move(parts), options);
+        else
+            for(ImportedMeshPart& part : parts)
+                imported->meshes.push_back(buildMesh(std::move(part), options));
+        if (sourceHash)
+            MeshCache::Save(cachePath, sourceHash, imported->meshes);
+        if (options.optimize)
+        {
+            std::cout << "Mesh optimization " << path << ": " << report.before.vertices << " -> " << report.after.vertices << " vertices, "
+                      << "ACMR " << report.before.ACMR() << " -> " << report.after.ACMR() << ", "
+                      << "ATVR " << report.before.ATVR() << " -> " << report.after.ATVR() << ", "
+                      << "overdraw " << report.before.Overdraw() << " -> " << report.after.Overdraw() << std::endl;
+        }
+    }
+
+    for(const ImportedMesh& mesh : imported->meshes)
+        for(const Texture& texture : mesh.textures)
+            if (imported->images.find(texture.path) == imported->images.end())
+                imported->images[texture.path] = std::make_shared<TextureImage>(DecodeTexture(texture.path.c_str(), imported->directory, texture.type == "texture_diffuse"));
+    return imported;
+}
+
+std::shared_ptr<Mesh> Model::UploadMesh(const ImportedModel& imported, size_t mesh)
+{
+    const ImportedMesh& source = imported.meshes[mesh];
+    std::vector<Texture> textures = source.textures;
+    for(Texture& texture : textures)
+    {
+        auto image = imported.images.find(texture.path);
+        texture.asset = AssetRegistry::GetTexture(texture.path, imported.directory, image != imported.images.end() ? image->second : nullptr);
+        texture.id = texture.asset->id;
+    }
+    auto result = std::make_shared<Mesh>(source.geometry, textures, source.vertices, source.indices);
+    result->SetName(source.name);
+    return result;
+}
+
+void Model::processNode(aiNode *node, const aiScene *scene, const ImportOptions& options, const std::string& directory, const glm::mat4& parentTransform, std::vector<ImportedMeshPart>& parts, MeshOptimizationReport& report)
+{
+    // aiMatrix4x4 is row-major
+    const glm::mat4 nodeTransform = parentTransform * glm::transpose(glm::make_mat4(&node->mTransformation.a1));
+    glm::mat4 transform{1.f};
+    glm::mat3 normalTransform{1.f};
+    if (options.batchStatic)
+    {
+        // batched meshes share one model matrix, so every node's full transform goes into the vertices
+        transform = nodeTransform;
+        normalTransform = glm::transpose(glm::inverse(glm::mat3(nodeTransform)));
+    }
+    else
+    {
+        for(int i = 0; i < 3; ++i)
+        {
+            if (node->mTransformation[i][i] != 1.f)
+            {
+                transform[i][i] = node->mTransformation[i][i];
+            }
+        }
+    }
+    for(GLuint i = 0; i < node->mNumMeshes; ++i)
+    {
+        aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
+        parts.push_back(processMesh(mesh, scene, options, directory, report, transform, normalTransform));
+    }
+
+    for(GLuint i = 0; i < node->mNumChildren; ++i)
+    {
+        processNode(node->mChildren[i], scene, options, directory, nodeTransform, parts, report);
+    }
+}
+
+ImportedMeshPart Model::processMesh(aiMesh *mesh, const aiScene *scene, const ImportOptions& options, const std::string& directory, MeshOptimizationReport& report,
+                                    const glm::mat4& transform, const glm::mat3& normalTransform)
+{
+    ImportedMeshPart part;
+    part.name = directory + '/' + mesh->mName.C_Str();
+    std::vector<Vertex>& vertices = part.vertices;
+    std::vector<GLuint>& indices = part.indices;
+    std::vector<Texture>& textures = part.textures;
+
+    for(GLuint i = 0; i < mesh->mNumVertices; ++i)
+    {
+        Vertex vertex;
+
+        vertex.Position = {mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z};
+        vertex.Position = glm::vec3(transform * glm::vec4(vertex.Position, 1.f));
+        vertex.Normal = {mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z};
+        if (options.batchStatic)
+            vertex.Normal = glm::normalize(normalTransform * vertex.Normal);
+        if (mesh->mTextureCoords[0])
+            vertex.TexCoords = {mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y};
+        else
+            vertex.TexCoords = {0.f, 0.f};
+        
+        vertices.push_back(vertex);
+    }
+    
+    for(GLuint i = 0; i < mesh->mNumFaces; ++i)
+    {
+        const aiFace& face = mesh->mFaces[i];
+        for(GLuint j = 0; j < face.mNumIndices; ++j)
+            indices.push_back(face.mIndices[j]);
+    }
+
+    if (options.optimize)
+    {
+        MeshOptimizationReport meshReport = MeshOptimizer::Optimize(vertices, indices);
+        report.before += meshReport.before;
+        report.after += meshReport.after;
+    }
+
+    if (mesh->mMaterialIndex >= 0)
+    {
+        aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
+        std::vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
+        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+        std::vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
+        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+    }
+
+    return part;
+}
+
+ImportedMesh Model::buildMesh(ImportedMeshPart part, const ImportOptions& options)
+{
+    std::vector<Vertex>& vertices = part.vertices;
+    std::vector<GLuint>& indices = part.indices;
+    std::vector<std::vector<GLuint>> lodIndices;
+    std::vector<float> lodErrors;
+    if (options.optimize && options.generateLods && indices.size() / 3 >= MIN_LOD_TRIANGLES)
+    {
+        size_t previousCount = indices.size();
+        for(int level = 1; level < MAX_LODS; ++level)
+        {
+            // every level is simplified from the full mesh so that errors don't pile up
+            const size_t target = size_t(previousCount * LOD_TRIANGLES_RATIO) / 3 * 3;
+            float error = 0.f;
+            std::vector<GLuint> lod = MeshOptimizer::Simplify(vertices, indices, target, LOD_MAX_ERROR[level], &error);
+            // stuck on the error bound, another level would draw about the same
+            if (lod.empty() || lod.size() > previousCount * 0.9f)
+                break;
+            MeshOptimizer::OptimizeVertexCache(lod, vertices.size());
+            previousCount = lod.size();
+            lodIndices.push_back(std::move(lod));
+            lodErrors.push_back(error);
+        }
+    }
+
+    ImportedMesh result;
+    result.name = std::move(part.name);
+    result.textures = std::move(part.textures);
+    result.geometry = Mesh::BuildGeometry(vertices, indices, lodIndices, lodErrors, result.vertexData, result.indexData);
+    if (options.keepCpuData)
+    {
+        result.vertices = std::move(vertices);
+        result.indices = std::move(indices);
+    }
+    return result;
+}
+
+// Parts are already optimized on their own, the batch keeps them as consecutive index ranges
+std::vector<ImportedMesh> Model::batchParts(std::vector<ImportedMeshPart> parts, const ImportOptions& options)
+{
+    std::vector<ImportedMeshPart> batches;
+    std::vector<std::vector<SubMesh>> batchSubMeshes;
+    // the shader is the model's, so the textures are all that tell materials apart
+    std::map<std::string, size_t> batchByTextures;
+    for(ImportedMeshPart& part : parts)
+    {
+        std::string key;
+        for(const Texture& texture : part.textures)
+            key += texture.type + '|' + texture.path + '\n';
+        auto found = batchByTextures.find(key);
+        if (found == batchByTextures.end())
+        {
+            found = batchByTextures.emplace(key, batches.size()).first;
+            batches.emplace_back();
+            batches.back().name = part.name;
+            batches.back().textures = part.textures;
+            batchSubMeshes.emplace_back();
+        }
+        ImportedMeshPart& batch = batches[found->second];
+
+        SubMesh subMesh;
+        subMesh.name = part.name;
+        subMesh.firstIndex = (GLsizei)batch.indices.size();
+        subMesh.indexCount = (GLsizei)part.indices.size();
+        if (!part.vertices.empty())
+            subMesh.boundsMin = subMesh.boundsMax = part.vertices[0].Position;
+        for(const Vertex& vertex : part.vertices)
+        {
+            subMesh.boundsMin = glm::min(subMesh.boundsMin, vertex.Position);
+            subMesh.boundsMax = glm::max(subMesh.boundsMax, vertex.Position);
+        }
+        batchSubMeshes[found->second].push_back(subMesh);
+
+        const GLuint baseVertex = (GLuint)batch.vertices.size();
+        batch.vertices.insert(batch.vertices.end(), part.vertices.begin(), part.vertices.end());
+        for(GLuint index : part.indices)
+            batch.indices.push_back(baseVertex + index);
+    }
+
+    std::vector<ImportedMesh> meshes;
+    for(size_t i = 0; i < batches.size(); ++i)
+    {
+        if (batchSubMeshes[i].size() > 1)
+            batches[i].name += " +" + std::to_string(batchSubMeshes[i].size() - 1);
+        meshes.push_back(buildMesh(std::move(batches[i]), options));
+        if (batchSubMeshes[i].size() > 1)
+            meshes.back().geometry.subMeshes = std::move(batchSubMeshes[i]);
+    }
+    return meshes;
+}
+
+std::vector<Texture> Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName)
+{
+    std::vector<Texture> textures;
+    for(GLuint i = 0; i < mat->GetTextureCount(type); ++i)
+    {
+        aiString str;
+        mat->GetTexture(type, i, &str);
+        Texture texture;
+        texture.id = 0;
+        texture.type = typeName;
+        texture.path = str.C_Str();
+        textures.push_back(texture);
+    }
+
+    return textures;
+}
+
+void Model::ChangeName(const std::string& newName)
+{
+    name = std::to_string(ID) + '_' + newName;
+}
+
+TextureImage DecodeTexture(const char *path, const std::string& directory, bool srgb/* = true*/, bool compress/* = true*/)
+{
+    TextureImage image;
+    image.filename = path;
+    if (!directory.empty())
+        image.filename = directory + '/' + image.filename;
+    // shared with Assimp's reads, textures used by many models are mapped once
+    std::shared_ptr<const MappedFile> source = MappedIOSystem::Map(image.filename);
+    if (!source)
+    {
+        image.filename = "textures/" + std::string(path);
+        source = MappedIOSystem::Map(image.filename);
+    }
+    if (!source)
+    {
+        std::cerr << "Texture failed to load at path: " << image.filename << std::endl;
+        return image;
+    }
+
+    TraceScope trace("texture", "Decode " + image.filename);
+    const uint64_t sourceHash = Hash64(source->Data(), source->Size());
+    compress = compress && TextureCompressor::enabled;
+    const std::string cachePath = TextureCache::CachePath(image.filename, srgb, compress);
+    if (TextureCache::Read(cachePath, sourceHash, image))
+        return image;
+
+    GLubyte *data = stbi_load_from_memory(source->Data(), (int)source->Size(), &image.width, &image.height, &image.channels, 0);
+    if (!data)
+    {
+        std::cerr << "Texture failed to load at path: " << image.filename << std::endl;
+        return image;
+    }
+    image.pixels.assign(data, data + size_t(image.width) * image.height * image.channels);
+    image.levelOffsets = {0};
+    stbi_image_free(data);
+
+    GenerateMipmaps(image, srgb);
+    if (GLenum format = compress ? TextureCompressor::PickFormat(image) : 0)
+        TextureCompressor::Compress(image, format);
+    TextureCache::Save(cachePath, sourceHash, image);
+    return image;
+}
+
+GLuint TextureFromFile(const char *path, const std::string& directory, bool gamma/* = false*/)
+{
+    return TextureStreamer::Create(std::make_shared<TextureImage>(DecodeTexture(path, directory)));
+}
+
+void Model::SortFaces()
+{
+    if (meshes.empty())
+        return;
+    Mesh& cubeMesh = *meshes[0];
+    if (!cubeMesh.HasCpuData())
+    {
+        std::cerr << "ERROR::MODEL::SORT_FACES_WITHOUT_CPU_DATA " << name << std::endl;
+        return;
+    }
+    const size_t facesCount = 6;
+    const size_t faceIndicesCount = cubeMesh.indices.size() / facesCount;
+    std::vector<std::pair<bool, size_t>> sortedFaces;
+    for(size_t face = 0; face < facesCount; ++face)
+    {
+        const size_t firstIndexOfFace = face*facesCount;
+        const glm::vec3 faceNorm = glm::mat3(glm::transpose(glm::inverse(modelMat))) * cubeMesh.vertices[firstIndexOfFace].Normal;
+        const glm::vec3 vertexWorldPosition = glm::vec3{modelMat * glm::vec4{cubeMesh.vertices[firstIndexOfFace].Position, 1.f}};
+        const glm::vec3 dirToCam = glm::normalize(DATA.camera.Position - vertexWorldPosition);
+        bool lookToCam = glm::dot(faceNorm, dirToCam) >= 0.f;
+        sortedFaces.emplace_back(lookToCam, face);
+    }
+    std::sort(sortedFaces.begin(), sortedFaces.end(), [](const std::pair<bool, size_t>& p1, const std::pair<bool, size_t>& p2) {
+        return p1.first < p2.first;
+    });
+
+    std::vector<GLuint> sortedIndices;
+    sortedIndices.reserve(cubeMesh.indices.size());
+    for(auto& p : sortedFaces)
+    {
+        for(size_t i = 0; i < faceIndicesCount; ++i)
+            sortedIndices.push_back(GLuint(p.second * faceIndicesCount + i));
+    }
+
+    // most camera moves don't change the order, upload only the faces that moved
+    size_t first = 0;
+    size_t last = sortedIndices.size();
+    while (first < last && sortedIndices[first] == cubeMesh.indices[first])
+        ++first;
+    while (last > first && sortedIndices[last - 1] == cubeMesh.indices[last - 1])
+        --last;
+    if (first == last)
+        return;
+    std::copy(sortedIndices.begin() + first, sortedIndices.begin() + last, cubeMesh.indices.begin() + first);
+    cubeMesh.MarkIndicesDirty(first, last - first);
 }
\ No newline at end of file
@@ -1,79 +1,128 @@
-#pragma once
-#include <vector>
-#include <string>
-#include "glad/glad.h"
-#include "mesh.h"
-
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/material.h>
-#include <assimp/postprocess.h>
-
-class Shader;
-
-class Model
-{
-public:
-    Model(const char *path, int shaderId)
-        : ID(NEXT_ID++)
-    {
-        loadModel(path);
-        std::string sPath{path};
-        size_t pos = sPath.find_last_of('/') + 1;
-        size_t count = sPath.find_last_of('.') - pos;
-        name = std::to_string(ID) + "_" + sPath.substr(pos, count);
-
-        shaderID = shaderId;
-    }
-    Model(const Mesh& mesh, int shaderId, glm::vec3 location_ = {0.f, 0.f, 0.f}, glm::vec3 scale_ = {1.f, 1.f, 1.f}, glm::vec3 rotation_ = {0.f, 0.f, 0.f});
-    void DrawPointLight();
-    void DrawSpotLight(float angle, glm::vec3 axis);
-    void DrawModel();
-
-    const glm::vec3& GetLocation() const { return location; }
-    void SetLocation(const glm::vec3& location);
-    const glm::vec3& GetScale() const { return scale; }
-    void SetScale(const glm::vec3& location);
-    const glm::vec3& GetRotation() const { return rotation; }
-    void SetRotation(const glm::vec3& rotation);
-    
-    void SortFaces();
-
-    bool solidColor = false;
-    glm::vec4 color{0.f, 0.f, 0.f, 1.f};
-
-    float shininess = 32.f;
-
-    bool outline = false;
-    bool opaque = false;
-    bool transparentCube = false;
-    int shaderID = 0;
-    int ID = 0;
-
-    const std::string& GetName() const { return name; }
-    void ChangeName(const std::string& newName);
-
-private:
-    std::vector<Texture> textures_loaded;
-    std::vector<Mesh> meshes;
-    std::string directory;
-    std::string name;
-    
-    void Draw(Shader& shader);
-
-    void loadModel(std::string path);
-    void processNode(aiNode *node, const aiScene *scene);
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene, glm::mat3 scale = glm::mat3{1.f});
-    std::vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
-
-    static int NEXT_ID;
-    
-    glm::mat4 modelMat{1.f};
-    
-    glm::vec3 location{0.f};
-    glm::vec3 scale{1.f};
-    glm::vec3 rotation{0.f};
-};
-
-GLuint TextureFromFile(const char *path, const std::string& directory, bool gamma = false);
-GLuint CubemapFromFile(const std::vector<std::string> &faces);
\ No newline at end of file
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+#include "glad/glad.h"
+#include "mesh.h"
+#include "MeshOptimizer.h"
+#include "AssetRegistry.h"
+#include "MeshCache.h"
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/material.h>
+#include <assimp/postprocess.h>
+
+class Shader;
+
+class Model
+{
+public:
+    Model(const char *path, int shaderId, const ImportOptions& options = ImportOptions{})
+        : Model(std::string{path}, shaderId, AssetRegistry::GetModel(path, options))
+    {
+    }
+    // `asset` may be null while it loads elsewhere, see SetAsset and SceneLoader
+    Model(const std::string& path, int shaderId, std::shared_ptr<const ModelAsset> asset_)
+        : ID(NEXT_ID++)
+    {
+        SetAsset(std::move(asset_));
+        size_t pos = path.find_last_of('/') + 1;
+        size_t count = path.find_last_of('.') - pos;
+        name = std::to_string(ID) + "_" + path.substr(pos, count);
+
+        shaderID = shaderId;
+    }
+    Model(std::shared_ptr<Mesh> mesh, int shaderId, glm::vec3 location_ = {0.f, 0.f, 0.f}, glm::vec3 scale_ = {1.f, 1.f, 1.f}, glm::vec3 rotation_ = {0.f, 0.f, 0.f});
+    void DrawPointLight();
+    void DrawSpotLight(float angle, glm::vec3 axis);
+    void DrawModel();
+
+    // Same meshes, shader and compile-time material flags, see DrawInstanced
+    bool CanInstanceWith(const Model& other) const;
+    // Draws models that can all be instanced with the first one in a single call per mesh,
+    // in the given order. Returns false, drawing nothing, while the instanced program compiles.
+    static bool DrawInstanced(Model* const* models, size_t count);
+    // Equal for models that may be instanced together, groups them when order doesn't matter
+    const void* InstanceKey() const { return meshes.empty() ? nullptr : meshes[0].get(); }
+
+    // Replaces the meshes, models are drawn without any until their asset is set
+    void SetAsset(std::shared_ptr<const ModelAsset> asset);
+    bool IsLoaded() const { return !meshes.empty(); }
+
+    // Read and UploadMesh of every mesh at once, use AssetRegistry::GetModel to share the result
+    static std::shared_ptr<ModelAsset> Import(const std::string& path, const ImportOptions& options);
+    // CPU half of an import, safe on any thread: the baked file or Assimp, optimization, texture decoding
+    static std::unique_ptr<ImportedModel> Read(const std::string& path, const ImportOptions& options);
+    // GL half, creates one mesh of the import and the textures it samples
+    static std::shared_ptr<Mesh> UploadMesh(const ImportedModel& imported, size_t mesh);
+
+    static const int MAX_LODS = 4;
+    int GetLod() const { return currentLod; }
+    int LodCount() const;
+    size_t LodTrianglesCount(int lod) const;
+
+    const glm::vec3& GetLocation() const { return location; }
+    void SetLocation(const glm::vec3& location);
+    const glm::vec3& GetScale() const { return scale; }
+    void SetScale(const glm::vec3& location);
+    const glm::vec3& GetRotation() const { return rotation; }
+    void SetRotation(const glm::vec3& rotation);
+    
+    void SortFaces();
+
+    bool solidColor = false;
+    glm::vec4 color{0.f, 0.f, 0.f, 1.f};
+
+    float shininess = 32.f;
+
+    bool outline = false;
+    bool opaque = false;
+    bool transparentCube = false;
+    int shaderID = 0;
+    int ID = 0;
+
+    const std::string& GetName() const { return name; }
+    void ChangeName(const std::string& newName);
+
+private:
+    std::shared_ptr<const ModelAsset> asset; // null for models built from a mesh
+    std::vector<std::shared_ptr<Mesh>> meshes; // shared by models drawn instanced
+    std::string name;
+    
+    void Draw(Shader& shader, int lod = 0);
+    void setModelUniforms(const Shader& shader);
+    void computeBounds();
+    void updateModelMatrix();
+    int selectLod();
+
+    static void processNode(aiNode *node, const aiScene *scene, const ImportOptions& options, const std::string& directory, const glm::mat4& parentTransform, std::vector<ImportedMeshPart>& parts, MeshOptimizationReport& report);
+    static ImportedMeshPart processMesh(aiMesh *mesh, const aiScene *scene, const ImportOptions& options, const std::string& directory, MeshOptimizationReport& report,
+                                        const glm::mat4& transform, const glm::mat3& normalTransform);
+    // LODs and the arena layout of a part
+    static ImportedMesh buildMesh(ImportedMeshPart part, const ImportOptions& options);
+    // one mesh per texture set, see ImportOptions::batchStatic
+    static std::vector<ImportedMesh> batchParts(std::vector<ImportedMeshPart> parts, const ImportOptions& options);
+    static std::vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
+
+    static int NEXT_ID;
+    
+    glm::mat4 modelMat{1.f};
+    
+    glm::vec3 location{0.f};
+    glm::vec3 scale{1.f};
+    glm::vec3 rotation{0.f};
+
+    // bounding sphere of all meshes in model space
+    glm::vec3 boundsCenter{0.f};
+    float boundsRadius = 0.f;
+    int currentLod = 0;
+};
+
+// Thread-safe, falls back to the textures directory. Reads the cooked file from
+// TextureCache, or builds the whole mip chain, compresses and cooks it on a miss.
+// `srgb` is for color textures, their mips are filtered in linear space.
+// Without `compress` the levels are plain channels, e.g. to be copied into an atlas.
+TextureImage DecodeTexture(const char *path, const std::string& directory, bool srgb = true, bool compress = true);
+// Decodes right away, the texture streams in through TextureStreamer
+GLuint TextureFromFile(const char *path, const std::string& directory, bool gamma = false);
\ No newline at end of file
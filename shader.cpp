@@ -1,172 +1,532 @@
-#include "shader.h"
-#include <glm/gtc/type_ptr.hpp>
-
-Shader::Shader(const GLchar *vertexPath, const GLchar *fragmentPath)
-{
-    char *vShaderCode = new char[4096];
-    char *fShaderCode = new char[8192];
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-
-    std::string sVertexPath{vertexPath};
-    size_t pos = sVertexPath.find_last_of('/') + 1;
-    vShaderName = sVertexPath.substr(pos);
-    
-    std::string sFragmentPath{fragmentPath};
-    pos = sFragmentPath.find_last_of('/') + 1;
-    fShaderName = sFragmentPath.substr(pos);
-
-    //vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    //fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    try
-    {
-        vShaderFile.open(vertexPath);
-		vShaderFile.seekg(0, vShaderFile.end);
-		std::streampos vertexLength = vShaderFile.tellg();
-		vShaderFile.seekg(0, vShaderFile.beg);
-		fShaderFile.open(fragmentPath);
-		fShaderFile.seekg(0, fShaderFile.end);
-		std::streampos fragmentLength = fShaderFile.tellg();
-		fShaderFile.seekg(0, fShaderFile.beg);
-
-        vShaderFile.read(vShaderCode, vertexLength);
-		vShaderCode[vertexLength] = 0;
-		fShaderFile.read(fShaderCode, fragmentLength);
-		fShaderCode[fragmentLength] = 0;
-
-        vShaderFile.close();
-        fShaderFile.close();
-    }
-    catch(std::ifstream::failure e)
-    {
-        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
-    }    
-
-    GLuint vertex, fragment;
-    int success;
-    GLchar infoLog[512];
-
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if(!success)
-    {
-        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
-                  << infoLog << std::endl;
-    }
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n"
-                  << infoLog << std::endl;
-    }
-
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
-    glGetProgramiv(ID, GL_LINK_STATUS, &success);
-    if (!success)
-    {
-        glGetProgramInfoLog(ID, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-                  << infoLog << std::endl;
-    }
-
-    delete[] vShaderCode;
-    delete[] fShaderCode;
-
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
-}
-
-void Shader::use()
-{
-    glUseProgram(ID);
-}
-
-void Shader::set(const std::string& name, bool value) const
-{
-    GLint loc = getUniformLoc(name);
-    glUniform1i(loc, (int)value);
-}
-
-void Shader::set(const std::string &name, int value) const
-{
-    GLint loc = getUniformLoc(name);
-    glUniform1i(loc, value);
-}
-
-void Shader::set(const std::string &name, float value) const
-{
-    GLint loc = getUniformLoc(name);
-    glUniform1f(loc, value);
-}
-
-void Shader::set(const std::string &name, float f1, float f2, float f3, float f4) const
-{
-    GLint loc = getUniformLoc(name);
-    glUniform4f(loc, f1, f2, f3, f4);
-}
-
-void Shader::set(const std::string &name, float x, float y, float z) const
-{
-    GLint loc = getUniformLoc(name);
-    glUniform3f(loc, x, y, z);
-}
-
-void Shader::set(const std::string &name, const glm::vec3 &vec) const
-{
-    GLint loc = getUniformLoc(name);
-    glUniform3f(loc, vec.x, vec.y, vec.z);
-}
-
-void Shader::set(const std::string &name, const glm::vec4 &vec) const
-{
-    GLint loc = getUniformLoc(name);
-    glUniform4f(loc, vec.x, vec.y, vec.z, vec.w);
-}
-
-void Shader::set(const std::string &name, const glm::mat4 &mat) const
-{
-    GLint loc = getUniformLoc(name);
-    glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(mat));
-}
-
-void Shader::set(const std::string &name, float *f, int count)
-{
-    GLint loc = getUniformLoc(name);
-    glUniform1fv(loc, count, f);
-}
-
-GLint Shader::getUniformLoc(const std::string &name) const
-{
-    auto it = checkedUniforms.find(name);
-    if (it != checkedUniforms.end())
-    {
-        if (it->second)
-            return glGetUniformLocation(ID, name.c_str());
-        else
-            return -1;
-    }
-    else
-    {
-        GLint loc = glGetUniformLocation(ID, name.c_str());
-        if (loc == -1)
-        {
-            std::cerr << "ERROR::SHADER::PROGRAM::NO_UNIFORM " << name << std::endl;
-            checkedUniforms[name] = false;
-        }
-        else
-        {
-            checkedUniforms[name] = true;
-        }
-        return loc;
-    }
-}
\ No newline at end of file
+#include "shader.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include "UniformBuffer.h"
+#include "GLState.h"
+#include "GLExtensions.h"
+#include "FileUtils.h"
+#include "Hash.h"
+#include "Trace.h"
+#include <cstring>
+
+static const int MAX_INCLUDE_DEPTH = 8;
+
+// Reads a GLSL file and expands `#include "file"` lines relative to the including file
+static bool loadShaderSource(const std::string &path, std::string &out, int depth = 0)
+{
+    std::ifstream file(path);
+    if (!file.is_open() || depth > MAX_INCLUDE_DEPTH)
+    {
+        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+        return false;
+    }
+
+    const std::string directory = path.substr(0, path.find_last_of('/') + 1);
+    const std::string includeDirective = "#include";
+    bool result = true;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        size_t pos = line.find_first_not_of(" \t");
+        if (pos != std::string::npos && line.compare(pos, includeDirective.size(), includeDirective) == 0)
+        {
+            size_t first = line.find('"', pos);
+            size_t last = line.find('"', first + 1);
+            if (first != std::string::npos && last != std::string::npos)
+            {
+                result = loadShaderSource(directory + line.substr(first + 1, last - first - 1), out, depth + 1) && result;
+                continue;
+            }
+        }
+        out += line;
+        out += '\n';
+    }
+    return result;
+}
+
+namespace
+{
+    const char PROGRAM_BINARY_MAGIC[4] = {'G', 'L', 'P', 'B'};
+
+    struct ProgramBinaryHeader
+    {
+        char magic[4];
+        uint32_t format;
+        uint32_t length;
+    };
+
+    // a driver update invalidates every binary, so the driver identity is part of the key
+    uint64_t driverHash()
+    {
+        static const uint64_t hash = [] {
+            uint64_t h = HASH64_SEED;
+            for(GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+            {
+                const char *str = (const char*)glGetString(name);
+                h = Hash64(str ? str : "", h);
+            }
+            return h;
+        }();
+        return hash;
+    }
+}
+
+std::string Shader::cacheDirectory = "shader_cache";
+ProgramCacheStats Shader::cacheStats;
+UniformUploadStats Shader::currentUniformStats;
+UniformUploadStats Shader::lastUniformStats;
+
+static void insertDefines(std::string &source, const std::string &defines)
+{
+    if (defines.empty())
+        return;
+    size_t versionPos = source.find("#version");
+    size_t pos = versionPos == std::string::npos ? 0 : source.find('\n', versionPos);
+    pos = pos == std::string::npos ? source.size() : pos + 1;
+    source.insert(pos, defines);
+}
+
+Shader::Shader(const GLchar *vertexPath_, const GLchar *fragmentPath_, const std::string &defines_/* = ""*/)
+    : vertexPath(vertexPath_)
+    , fragmentPath(fragmentPath_)
+    , defines(defines_)
+{
+    vShaderName = vertexPath.substr(vertexPath.find_last_of('/') + 1);
+    fShaderName = fragmentPath.substr(fragmentPath.find_last_of('/') + 1);
+    TraceScope trace("shader", "Create " + vShaderName + " + " + fShaderName);
+
+    std::string vShaderSource, fShaderSource;
+    loadShaderSource(vertexPath, vShaderSource);
+    loadShaderSource(fragmentPath, fShaderSource);
+    permutable = fShaderSource.find("#pragma permutable") != std::string::npos;
+    insertDefines(vShaderSource, defines);
+    insertDefines(fShaderSource, defines);
+
+    if (GLExt::programBinary && !cacheDirectory.empty())
+    {
+        uint64_t key = Hash64(fShaderSource, Hash64(vShaderSource, driverHash()));
+        cachePath = cacheDirectory + "/" + HashToString(key) + ".bin";
+    }
+
+    if (!cachePath.empty() && loadCachedBinary(cachePath))
+    {
+        ++cacheStats.hits;
+        onLinked();
+    }
+    else
+    {
+        ++cacheStats.misses;
+        submitCompile(vShaderSource, fShaderSource);
+    }
+}
+
+// Only queues work for the driver: no status is queried here so compiles of
+// several programs can overlap. Finish() or Poll() collect the results.
+void Shader::submitCompile(const std::string &vShaderSource, const std::string &fShaderSource)
+{
+    const GLchar *vShaderCode = vShaderSource.c_str();
+    const GLchar *fShaderCode = fShaderSource.c_str();
+
+    pendingVertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(pendingVertex, 1, &vShaderCode, NULL);
+    glCompileShader(pendingVertex);
+
+    pendingFragment = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(pendingFragment, 1, &fShaderCode, NULL);
+    glCompileShader(pendingFragment);
+
+    ID = glCreateProgram();
+    if (GLExt::programBinary)
+        GLExt::ProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glAttachShader(ID, pendingVertex);
+    glAttachShader(ID, pendingFragment);
+    glLinkProgram(ID);
+
+    state = PENDING;
+}
+
+bool Shader::Poll()
+{
+    if (state != PENDING)
+        return state == READY;
+
+    if (GLExt::parallelShaderCompile)
+    {
+        GLint completed = GL_FALSE;
+        glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &completed);
+        if (!completed)
+            return false;
+    }
+    return Finish();
+}
+
+bool Shader::Finish()
+{
+    if (state != PENDING)
+        return state == READY;
+
+    TraceScope trace("shader", "Link " + vShaderName + " + " + fShaderName);
+    int success;
+    GLchar infoLog[512];
+
+    glGetShaderiv(pendingVertex, GL_COMPILE_STATUS, &success);
+    if(!success)
+    {
+        glGetShaderInfoLog(pendingVertex, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED " << vShaderName << "\n"
+                  << infoLog << std::endl;
+    }
+    glGetShaderiv(pendingFragment, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(pendingFragment, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED " << fShaderName << "\n"
+                  << infoLog << std::endl;
+    }
+
+    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(ID, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
+                  << infoLog << std::endl;
+    }
+
+    glDetachShader(ID, pendingVertex);
+    glDetachShader(ID, pendingFragment);
+    glDeleteShader(pendingVertex);
+    glDeleteShader(pendingFragment);
+    pendingVertex = pendingFragment = 0;
+
+    if (!success)
+    {
+        state = FAILED;
+        return false;
+    }
+
+    if (!cachePath.empty())
+        saveCachedBinary(cachePath);
+    onLinked();
+    return true;
+}
+
+void Shader::onLinked()
+{
+    reflectUniforms();
+    bindUniformBlocks();
+    state = READY;
+}
+
+bool Shader::loadCachedBinary(const std::string &cachePath)
+{
+    std::vector<char> file;
+    if (!ReadFile(cachePath, file))
+        return false;
+
+    ProgramBinaryHeader header;
+    if (file.size() < sizeof(header))
+        return false;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, PROGRAM_BINARY_MAGIC, sizeof(header.magic)) != 0 || file.size() != sizeof(header) + header.length)
+        return false;
+
+    ID = glCreateProgram();
+    GLExt::ProgramBinary(ID, header.format, file.data() + sizeof(header), (GLsizei)header.length);
+    GLint success = 0;
+    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        // the driver may reject binaries for its own reasons, just compile from source
+        ++cacheStats.rejected;
+        glDeleteProgram(ID);
+        ID = 0;
+        return false;
+    }
+    return true;
+}
+
+void Shader::saveCachedBinary(const std::string &cachePath)
+{
+    GLint length = 0;
+    glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> file(sizeof(ProgramBinaryHeader) + length);
+    ProgramBinaryHeader header;
+    std::memcpy(header.magic, PROGRAM_BINARY_MAGIC, sizeof(header.magic));
+    GLsizei written = 0;
+    GLExt::GetProgramBinary(ID, length, &written, &header.format, file.data() + sizeof(header));
+    header.length = (uint32_t)written;
+    std::memcpy(file.data(), &header, sizeof(header));
+    file.resize(sizeof(header) + written);
+
+    if (!EnsureDirectory(cacheDirectory) || !WriteFile(cachePath, file.data(), file.size()))
+        std::cerr << "ERROR::SHADER::PROGRAM::CACHE_WRITE_FAILED " << cachePath << std::endl;
+}
+
+const ProgramCacheStats &Shader::CacheStats()
+{
+    return cacheStats;
+}
+
+void Shader::use()
+{
+    GLState::UseProgram(ID);
+}
+
+void Shader::bindUniformBlocks()
+{
+    GLint count = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    for(GLint i = 0; i < count; ++i)
+    {
+        GLchar name[64];
+        glGetActiveUniformBlockName(ID, (GLuint)i, sizeof(name), NULL, name);
+        GLuint binding = UniformBlockBinding(name);
+        if (binding != INVALID_BLOCK_BINDING)
+            glUniformBlockBinding(ID, (GLuint)i, binding);
+        else
+            std::cerr << "ERROR::SHADER::PROGRAM::UNKNOWN_UNIFORM_BLOCK " << name << std::endl;
+    }
+}
+
+static GLint uniformTypeSize(GLenum type)
+{
+    switch (type)
+    {
+    case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: case GL_BOOL_VEC2:
+        return 8;
+    case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: case GL_BOOL_VEC3:
+        return 12;
+    case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_UNSIGNED_INT_VEC4: case GL_BOOL_VEC4: case GL_FLOAT_MAT2:
+        return 16;
+    case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT3x2:
+        return 24;
+    case GL_FLOAT_MAT2x4: case GL_FLOAT_MAT4x2:
+        return 32;
+    case GL_FLOAT_MAT3:
+        return 36;
+    case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x3:
+        return 48;
+    case GL_FLOAT_MAT4:
+        return 64;
+    default:
+        return 4; // scalars and samplers
+    }
+}
+
+void Shader::reflectUniforms()
+{
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    size_t capacity = 16;
+    while (capacity < size_t(count) * 4)
+        capacity *= 2;
+    uniformTable.assign(capacity, UniformSlot{});
+    shadow.clear();
+
+    std::vector<GLchar> nameBuf(std::max(maxLength, 1));
+    for(GLint i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        UniformHandle handle;
+        glGetActiveUniform(ID, (GLuint)i, (GLsizei)nameBuf.size(), &length, &handle.size, &handle.type, nameBuf.data());
+        std::string name(nameBuf.data(), length);
+
+        // uniforms inside blocks have no location
+        handle.location = glGetUniformLocation(ID, name.c_str());
+        if (handle.location == -1)
+            continue;
+
+        // samplers and bools are written with glUniform1i, an int per element is enough for them
+        handle.shadowSize = uniformTypeSize(handle.type) * handle.size;
+        handle.shadowOffset = (GLint)shadow.size();
+        shadow.resize(shadow.size() + 1 + handle.shadowSize, 0);
+
+        addUniform(name, handle);
+
+        // plain arrays are reported once as "name[0]", register the bare name and every element too
+        const std::string arraySuffix = "[0]";
+        if (name.size() > arraySuffix.size() && name.compare(name.size() - arraySuffix.size(), arraySuffix.size(), arraySuffix) == 0)
+        {
+            std::string baseName = name.substr(0, name.size() - arraySuffix.size());
+            addUniform(baseName, handle);
+            for(GLint element = 1; element < handle.size; ++element)
+            {
+                std::string elementName = baseName + "[" + std::to_string(element) + "]";
+                // element writes overlap the array's shadow, they only invalidate it
+                UniformHandle elementHandle{glGetUniformLocation(ID, elementName.c_str()), handle.type, handle.size - element, handle.shadowOffset, 0};
+                if (elementHandle.IsValid())
+                    addUniform(elementName, elementHandle);
+            }
+        }
+    }
+}
+
+void Shader::addUniform(const std::string &name, const UniformHandle &handle)
+{
+    const uint32_t hash = HashUniformName(name.c_str());
+    const size_t mask = uniformTable.size() - 1;
+    size_t i = hash & mask;
+    for(; uniformTable[i].handle.IsValid(); i = (i + 1) & mask)
+    {
+        if (uniformTable[i].hash == hash && uniformTable[i].name == name)
+            return;
+    }
+    uniformTable[i].hash = hash;
+    uniformTable[i].name = name;
+    uniformTable[i].handle = handle;
+}
+
+UniformHandle Shader::GetUniform(UniformName name) const
+{
+    if (state != READY)
+        return {};
+
+    if (!uniformTable.empty())
+    {
+        const size_t mask = uniformTable.size() - 1;
+        for(size_t i = name.hash & mask; uniformTable[i].handle.IsValid(); i = (i + 1) & mask)
+        {
+            if (uniformTable[i].hash == name.hash && uniformTable[i].name == name.str)
+                return uniformTable[i].handle;
+        }
+    }
+
+    // variants strip whatever their defines make unused, that's expected
+    if (!IsVariant() && std::find(reportedMissing.begin(), reportedMissing.end(), name.hash) == reportedMissing.end())
+    {
+        std::cerr << "ERROR::SHADER::PROGRAM::NO_UNIFORM " << name.str << std::endl;
+        reportedMissing.push_back(name.hash);
+    }
+    return {};
+}
+
+void Shader::set(UniformHandle uniform, bool value) const
+{
+    if (!uniform.IsValid())
+        return;
+    const int intValue = (int)value;
+    if (!shadowChanged(uniform, &intValue, sizeof(intValue)))
+        return;
+    glUniform1i(uniform.location, intValue);
+}
+
+void Shader::set(UniformHandle uniform, int value) const
+{
+    if (!uniform.IsValid())
+        return;
+    if (!shadowChanged(uniform, &value, sizeof(value)))
+        return;
+    glUniform1i(uniform.location, value);
+}
+
+void Shader::set(UniformHandle uniform, float value) const
+{
+    if (!uniform.IsValid())
+        return;
+    if (!shadowChanged(uniform, &value, sizeof(value)))
+        return;
+    glUniform1f(uniform.location, value);
+}
+
+void Shader::set(UniformHandle uniform, float f1, float f2, float f3, float f4) const
+{
+    if (!uniform.IsValid())
+        return;
+    const float values[4] = {f1, f2, f3, f4};
+    if (!shadowChanged(uniform, values, sizeof(values)))
+        return;
+    glUniform4f(uniform.location, f1, f2, f3, f4);
+}
+
+void Shader::set(UniformHandle uniform, float x, float y, float z) const
+{
+    if (!uniform.IsValid())
+        return;
+    const float values[3] = {x, y, z};
+    if (!shadowChanged(uniform, values, sizeof(values)))
+        return;
+    glUniform3f(uniform.location, x, y, z);
+}
+
+void Shader::set(UniformHandle uniform, const glm::vec3 &vec) const
+{
+    if (!uniform.IsValid())
+        return;
+    if (!shadowChanged(uniform, glm::value_ptr(vec), sizeof(float) * 3))
+        return;
+    glUniform3f(uniform.location, vec.x, vec.y, vec.z);
+}
+
+void Shader::set(UniformHandle uniform, const glm::vec4 &vec) const
+{
+    if (!uniform.IsValid())
+        return;
+    if (!shadowChanged(uniform, glm::value_ptr(vec), sizeof(float) * 4))
+        return;
+    glUniform4f(uniform.location, vec.x, vec.y, vec.z, vec.w);
+}
+
+void Shader::set(UniformHandle uniform, const glm::mat4 &mat) const
+{
+    if (!uniform.IsValid())
+        return;
+    if (!shadowChanged(uniform, glm::value_ptr(mat), sizeof(float) * 16))
+        return;
+    glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::set(UniformHandle uniform, const float *f, int count) const
+{
+    if (!uniform.IsValid())
+        return;
+    if (!shadowChanged(uniform, f, sizeof(float) * count))
+        return;
+    glUniform1fv(uniform.location, count, f);
+}
+
+bool Shader::shadowChanged(const UniformHandle &uniform, const void *data, size_t size) const
+{
+    if (uniform.shadowOffset < 0)
+    {
+        ++currentUniformStats.uploaded;
+        return true;
+    }
+
+    uint8_t *known = &shadow[uniform.shadowOffset];
+    uint8_t *value = known + 1;
+    if (size > size_t(uniform.shadowSize))
+    {
+        // array element handles and oversized writes: upload and forget what the array holds
+        *known = 0;
+        ++currentUniformStats.uploaded;
+        return true;
+    }
+    if (*known && std::memcmp(value, data, size) == 0)
+    {
+        ++currentUniformStats.skipped;
+        return false;
+    }
+
+    std::memcpy(value, data, size);
+    // a partial array write only completes what was already known
+    if (size == size_t(uniform.shadowSize))
+        *known = 1;
+    ++currentUniformStats.uploaded;
+    return true;
+}
+
+void Shader::BeginFrame()
+{
+    lastUniformStats = currentUniformStats;
+    currentUniformStats = UniformUploadStats{};
+}
+
+const UniformUploadStats &Shader::LastFrameUniformStats()
+{
+    return lastUniformStats;
+}
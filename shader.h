@@ -1,40 +1,120 @@
-#ifndef SHADER_H
-#define SHADER_H
-
-#include <glad/glad.h>
-
-#include <string>
-#include <fstream>
-#include <sstream>
-#include <iostream>
-#include <glm/glm.hpp>
-#include <map>
-
-class Shader
-{
-public:
-    GLuint ID;
-    std::string vShaderName;
-    std::string fShaderName;
-
-    Shader(const GLchar* vertexPath, const GLchar* fragmentPath);
-
-    void use();
-
-    void set(const std::string& name, bool value) const;
-    void set(const std::string& name, int value) const;
-    void set(const std::string& name, float value) const;
-    void set(const std::string &name, float x, float y, float z) const;
-    void set(const std::string &name, const glm::vec3 &vec) const;
-    void set(const std::string &name, const glm::vec4 &vec) const;
-    void set(const std::string &name, const glm::mat4 &mat) const;
-    void set(const std::string &name, float f1, float f2, float f3, float f4) const;
-    void set(const std::string &name, float *f, int count);
-
-private:
-    GLint getUniformLoc(const std::string &name) const;
-
-    mutable std::map<std::string, bool> checkedUniforms; // true - is active
-};
-
-#endif
\ No newline at end of file
+#ifndef SHADER_H
+#define SHADER_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "uniforms.h"
+
+struct ProgramCacheStats
+{
+    unsigned hits = 0;
+    unsigned misses = 0;
+    unsigned rejected = 0; // binaries found on disk but refused by the driver, counted in misses too
+};
+
+struct UniformUploadStats
+{
+    unsigned uploaded = 0;
+    unsigned skipped = 0; // same bytes as the last value written to that location
+};
+
+class Shader
+{
+public:
+    GLuint ID = 0;
+    std::string vShaderName;
+    std::string fShaderName;
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::string defines;
+    bool permutable = false; // the fragment source has `#pragma permutable`
+
+    bool IsVariant() const { return !defines.empty(); }
+
+    // Starts compiling and linking without waiting for the driver, unless the program
+    // binary is cached. Defines are inserted right after #version in both stages.
+    Shader(const GLchar* vertexPath, const GLchar* fragmentPath, const std::string &defines = "");
+
+    bool IsReady() const { return state == READY; }
+    bool IsPending() const { return state == PENDING; }
+    // Non-blocking if the driver supports KHR_parallel_shader_compile, otherwise same as Finish
+    bool Poll();
+    // Blocks until the program is linked, returns false if it failed
+    bool Finish();
+
+    void use();
+
+    // program binaries are cached here, keyed by sources and driver. Empty disables the cache.
+    static std::string cacheDirectory;
+    static const ProgramCacheStats &CacheStats();
+
+    // Call once at the start of a frame, LastFrameUniformStats then holds the counts of the previous frame
+    static void BeginFrame();
+    static const UniformUploadStats &LastFrameUniformStats();
+
+    UniformHandle GetUniform(UniformName name) const;
+
+    void set(UniformHandle uniform, bool value) const;
+    void set(UniformHandle uniform, int value) const;
+    void set(UniformHandle uniform, float value) const;
+    void set(UniformHandle uniform, float x, float y, float z) const;
+    void set(UniformHandle uniform, const glm::vec3 &vec) const;
+    void set(UniformHandle uniform, const glm::vec4 &vec) const;
+    void set(UniformHandle uniform, const glm::mat4 &mat) const;
+    void set(UniformHandle uniform, float f1, float f2, float f3, float f4) const;
+    void set(UniformHandle uniform, const float *f, int count) const;
+
+    template<typename... Args>
+    void set(UniformName name, const Args&... args) const
+    {
+        set(GetUniform(name), args...);
+    }
+
+private:
+    struct UniformSlot
+    {
+        uint32_t hash = 0;
+        std::string name; // compared on a hash match, names may collide
+        UniformHandle handle;
+    };
+
+    enum State
+    {
+        PENDING,
+        READY,
+        FAILED
+    };
+
+    void submitCompile(const std::string &vShaderSource, const std::string &fShaderSource);
+    void onLinked();
+    bool loadCachedBinary(const std::string &cachePath);
+    void saveCachedBinary(const std::string &cachePath);
+    void reflectUniforms();
+    void bindUniformBlocks();
+    void addUniform(const std::string &name, const UniformHandle &handle);
+    bool shadowChanged(const UniformHandle &uniform, const void *data, size_t size) const;
+
+    State state = PENDING;
+    GLuint pendingVertex = 0;
+    GLuint pendingFragment = 0;
+    std::string cachePath;
+
+    // open addressing by name hash, filled once after linking
+    std::vector<UniformSlot> uniformTable;
+    mutable std::vector<uint32_t> reportedMissing;
+    // one "known" byte followed by the value for every shadowed uniform
+    mutable std::vector<uint8_t> shadow;
+
+    static ProgramCacheStats cacheStats;
+    static UniformUploadStats currentUniformStats;
+    static UniformUploadStats lastUniformStats;
+};
+
+#endif
@@ -1,4 +1,7 @@
 #version 330 core
+#pragma permutable
+
+#include "frame_data.glsl"
 
 struct Material {
 	sampler2D texture_diffuse1;
@@ -20,36 +23,7 @@ struct SampledMaterial {
 };
 
 ///////////////////// light calculation /////////////////////////////////////////
-struct DirLight {
-	vec3 direction;
-	
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
-
-struct SpotLight {
-	vec3 direction;
-	vec3 position;
-	float innerCutOff;
-	float outerCutOff;
-
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
-
-struct PointLight {
-	vec3 position;
-
-	float constant;
-	float linear;
-	float quadratic;
-
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
+#include "lights.glsl"
 
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, SampledMaterial sMaterial)
 {
@@ -98,28 +72,72 @@ vec3 CalcSpotLight(SpotLight light, vec3 fragPos, SampledMaterial sMaterial)
 }
 /////////////////////////////////////////////////////////////////////////////////
 
-#define NR_DIR_LIGHTS 10
-uniform DirLight dirLights[NR_DIR_LIGHTS];
-uniform int dirLightsCount;
-
-#define NR_POINT_LIGHTS 10
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform int pointLightsCount;
-
-#define NR_SPOT_LIGHTS 10
-uniform SpotLight spotLights[NR_SPOT_LIGHTS];
-uniform int spotLightsCount;
-
 out vec4 FragColor;
 
 in vec3 Normal;
 in vec3 FragPos;
 in vec2 TexCoords;
 
-uniform vec3 viewPos;
 uniform Material material;
-uniform bool isSolidColor;
+#ifdef INSTANCED
+flat in vec4 InstanceColor;
+flat in vec4 InstanceMaterial;
+#define color InstanceColor
+#define materialShininess InstanceMaterial.z
+#else
 uniform vec4 color;
+#define materialShininess material.shininess
+#endif
+
+#ifdef PERMUTATION
+// Specialized variant, see ShaderPermutation.h: no branches on uniforms, no unused fetches
+
+void main()
+{
+	vec3 norm = normalize(Normal);
+	vec3 viewDir = normalize(viewPos - FragPos);
+
+	SampledMaterial sMaterial;
+	sMaterial.shininess = materialShininess;
+#ifdef SOLID_COLOR
+	sMaterial.diffuse = color;
+	sMaterial.specular = color;
+	float alpha = color.a;
+#else
+	sMaterial.diffuse = texture(material.texture_diffuse1, TexCoords);
+#ifdef HAS_SPECULAR_MAP
+	sMaterial.specular = texture(material.texture_specular1, TexCoords);
+#else
+	// without a specular map the diffuse color doubles as specular
+	sMaterial.specular = sMaterial.diffuse;
+#endif
+	float alpha = sMaterial.diffuse.a;
+#endif
+
+#ifdef OPAQUE
+	alpha = 1.0;
+#endif
+
+	vec3 result = vec3(0.0, 0.0, 0.0);
+#if DIR_LIGHTS_COUNT > 0
+	for(int i = 0; i < DIR_LIGHTS_COUNT; i++)
+		result += CalcDirLight(dirLights[i], norm, viewDir, sMaterial);
+#endif
+#if POINT_LIGHTS_COUNT > 0
+	for(int i = 0; i < POINT_LIGHTS_COUNT; i++)
+		result += CalcPointLight(pointLights[i], norm, FragPos, viewDir, sMaterial);
+#endif
+#if SPOT_LIGHTS_COUNT > 0
+	for(int i = 0; i < SPOT_LIGHTS_COUNT; i++)
+		result += CalcSpotLight(spotLights[i], FragPos, sMaterial);
+#endif
+
+	FragColor = vec4(result, alpha);
+}
+
+#else
+
+uniform bool isSolidColor;
 uniform bool opaque;
 
 void main()
@@ -130,7 +148,7 @@ void main()
 	SampledMaterial sMaterial;
 	sMaterial.diffuse = texture(material.texture_diffuse1, TexCoords);
 	sMaterial.specular = texture(material.texture_specular1, TexCoords);
-	sMaterial.shininess = material.shininess;
+	sMaterial.shininess = materialShininess;
 	
 	float alpha = sMaterial.diffuse.a;
 
@@ -166,4 +184,6 @@ void main()
 	
 	FragColor = vec4(result, alpha);
 	//FragColor = vec4(sMaterial.diffuse);
-}
\ No newline at end of file
+}
+
+#endif
@@ -0,0 +1,9 @@
+// Per-frame camera data, see FrameData.h
+layout (std140) uniform FrameData
+{
+	mat4 view;
+	mat4 projection;
+	vec3 viewPos;
+	float time;
+	vec2 resolution;
+};
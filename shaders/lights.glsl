@@ -0,0 +1,45 @@
+// Scene lights, packed on the CPU side by LightBuffer (LightBuffer.h)
+struct DirLight {
+	vec3 direction;
+	
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+struct SpotLight {
+	vec3 direction;
+	vec3 position;
+	float innerCutOff;
+	float outerCutOff;
+
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+struct PointLight {
+	vec3 position;
+
+	float constant;
+	float linear;
+	float quadratic;
+
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+#define NR_DIR_LIGHTS 10
+#define NR_POINT_LIGHTS 10
+#define NR_SPOT_LIGHTS 10
+
+layout (std140) uniform Lights
+{
+	DirLight dirLights[NR_DIR_LIGHTS];
+	PointLight pointLights[NR_POINT_LIGHTS];
+	SpotLight spotLights[NR_SPOT_LIGHTS];
+	int dirLightsCount;
+	int pointLightsCount;
+	int spotLightsCount;
+};
@@ -0,0 +1,20 @@
+// Attributes of every Mesh, see GeometryArena. Packed meshes store positions
+// normalized to their bounds, meshPosition() maps them back to mesh space.
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+#ifdef INSTANCED
+// one element per instance, see GeometryArena::UploadInstances
+layout (location = 3) in mat4 aInstanceModel;
+layout (location = 7) in vec4 aInstanceColor;
+layout (location = 8) in vec4 aInstanceMaterial; // solid color, opaque, shininess
+#endif
+
+uniform vec3 meshPositionScale;
+uniform vec3 meshPositionOffset;
+
+vec3 meshPosition()
+{
+	return aPos * meshPositionScale + meshPositionOffset;
+}
@@ -1,11 +1,14 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec2 aTexCoords;
+#include "mesh_vertex.glsl"
 
+#ifdef INSTANCED
+#define model aInstanceModel
+flat out vec4 InstanceColor;
+flat out vec4 InstanceMaterial;
+#else
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#endif
+#include "frame_data.glsl"
 
 out vec3 Normal;
 out vec3 FragPos;
@@ -13,8 +16,13 @@ out vec2 TexCoords;
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(aPos, 1.0);
-	FragPos = vec3(model * vec4(aPos, 1.0));
+	vec3 position = meshPosition();
+	gl_Position = projection * view * model * vec4(position, 1.0);
+	FragPos = vec3(model * vec4(position, 1.0));
 	Normal = mat3(transpose(inverse(model))) * aNormal;
 	TexCoords = aTexCoords;
+#ifdef INSTANCED
+	InstanceColor = aInstanceColor;
+	InstanceMaterial = aInstanceMaterial;
+#endif
 }
\ No newline at end of file
@@ -1,11 +1,8 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec2 aTexCoords;
+#include "mesh_vertex.glsl"
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "frame_data.glsl"
 
 out vec3 Normal;
 out vec3 FragPos;
@@ -13,8 +10,9 @@ out vec2 TexCoords;
 
 void main()
 {
-	gl_Position = projection * view * model *vec4(aPos, 1.0);
-	FragPos = aPos;
+	vec3 position = meshPosition();
+	gl_Position = projection * view * model *vec4(position, 1.0);
+	FragPos = position;
 	Normal = aNormal;
 	TexCoords = aTexCoords;
 }
\ No newline at end of file
@@ -1,14 +1,14 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-
-uniform mat4 view;
-uniform mat4 projection;
+#include "frame_data.glsl"
 
 out vec3 TexCoords;
 
 void main()
 {
-	TexCoords = aPos;
-	vec4 pos = projection * view * vec4(aPos, 1.0);
-	gl_Position = pos.xyww;
+	// one triangle covering the screen, on the far plane
+	vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+	gl_Position = vec4(position, 1.0, 1.0);
+	// the view's translation is dropped, so the far plane point is the view direction.
+	// Its w is the same at every corner, which keeps the interpolation linear.
+	TexCoords = (inverse(projection * mat4(mat3(view))) * gl_Position).xyz;
 }
\ No newline at end of file
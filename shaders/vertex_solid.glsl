@@ -1,11 +1,8 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec2 aTexCoords;
+#include "mesh_vertex.glsl"
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "frame_data.glsl"
 
 out vec3 Normal;
 out vec3 FragPos;
@@ -13,7 +10,8 @@ out vec2 TexCoords;
 
 void main()
 {
-	vec3 scaledPos = aPos + aNormal * 0.05;
+	vec3 position = meshPosition();
+	vec3 scaledPos = position + aNormal * 0.05;
 	gl_Position = projection * view * model * vec4(scaledPos, 1.0);
 	FragPos = vec3(model * vec4(scaledPos, 1.0));
 	Normal = mat3(transpose(inverse(model))) * aNormal;
@@ -0,0 +1,118 @@
+#include "skybox.h"
+#include "AssetRegistry.h"
+#include "GLState.h"
+#include "MemoryTracker.h"
+#include "shader.h"
+#include "TextureImage.h"
+#include "Trace.h"
+#include "globalData.h"
+#include "model.h"
+#include <algorithm>
+#include <iostream>
+
+Skybox::Skybox(int shaderID_)
+    : shaderID(shaderID_)
+{
+    // the triangle's corners come from gl_VertexID, but core profiles draw nothing without a VAO
+    glGenVertexArrays(1, &vao);
+}
+
+Skybox::~Skybox()
+{
+    if (!AssetRegistry::HasContext())
+        return;
+    GLState::DeleteVertexArrays(1, &vao);
+    if (texture)
+    {
+        GLState::DeleteTextures(1, &texture);
+        MemoryTracker::Untrack(MEMORY_CUBEMAPS, MEMORY_OBJECT_TEXTURE, texture);
+    }
+}
+
+void Skybox::Load(const std::vector<std::string> &faces)
+{
+    if (faces.size() != FACE_COUNT)
+    {
+        std::cerr << "ERROR::SKYBOX::FACE_COUNT " << faces.size() << std::endl;
+        return;
+    }
+    // join the workers of a previous load before touching what they write
+    pool.reset();
+    name = faces[0];
+    images.assign(FACE_COUNT, nullptr);
+    facesLeft = FACE_COUNT;
+    // one thread per face at most, the scene loader's pool is busy meanwhile anyway
+    pool = std::make_unique<ThreadPool>(std::min<unsigned>(FACE_COUNT, std::max(std::thread::hardware_concurrency(), 2u) - 1));
+    for(int face = 0; face < FACE_COUNT; ++face)
+    {
+        pool->Submit([this, face, path = faces[face]]() {
+            images[face] = std::make_shared<TextureImage>(DecodeTexture(path.c_str(), ""));
+            --facesLeft;
+        });
+    }
+}
+
+void Skybox::upload()
+{
+    TraceScope trace("texture", "Upload skybox " + name);
+    // every face is decoded, nothing else runs on the workers
+    pool.reset();
+    const TextureImage &first = *images[0];
+    for(const auto &image : images)
+    {
+        // faces of a cubemap must match in size and format
+        if (image->LevelCount() == 0 || image->width != first.width || image->height != first.height ||
+            image->channels != first.channels || image->compressedFormat != first.compressedFormat ||
+            image->LevelCount() != first.LevelCount())
+        {
+            std::cerr << "ERROR::SKYBOX::FACES_MISMATCH " << image->filename << std::endl;
+            images.clear();
+            return;
+        }
+    }
+
+    glGenTextures(1, &texture);
+    GLState::BindTexture(GL_TEXTURE_CUBE_MAP, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for(int face = 0; face < FACE_COUNT; ++face)
+    {
+        const TextureImage &image = *images[face];
+        for(int level = 0; level < image.LevelCount(); ++level)
+        {
+            const GLenum target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + face;
+            if (image.compressedFormat)
+                glCompressedTexImage2D(target, level, image.compressedFormat, image.LevelWidth(level), image.LevelHeight(level), 0,
+                                       (GLsizei)image.LevelBytes(level), image.LevelPixels(level));
+            else
+                glTexImage2D(target, level, image.PixelFormat(), image.LevelWidth(level), image.LevelHeight(level), 0, image.PixelFormat(), GL_UNSIGNED_BYTE, image.LevelPixels(level));
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    MemoryTracker::Track(MEMORY_CUBEMAPS, MEMORY_OBJECT_TEXTURE, texture, name, first.GpuBytes() * FACE_COUNT);
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, first.LevelCount() - 1);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    // the mips are filtered per face, seamless sampling hides their edges
+    GLState::Enable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+    images.clear();
+}
+
+void Skybox::Draw()
+{
+    if (!texture && facesLeft == 0 && !images.empty())
+        upload();
+    Shader &shader = DATA.shadersManager.GetShader(shaderID);
+    if (!texture || !shader.IsReady())
+        return;
+
+    GLState::DepthMask(GL_FALSE);
+    shader.use();
+    GLState::BindVertexArray(vao);
+    GLState::BindTexture(GL_TEXTURE_CUBE_MAP, texture);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    GLState::DepthMask(GL_TRUE);
+}
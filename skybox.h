@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ThreadPool.h"
+
+struct TextureImage;
+
+// Cubemap drawn behind everything as one full-screen triangle, the view direction of each
+// pixel comes from the inverse view-projection. The faces are decoded in parallel on
+// workers that only live until the upload, through DecodeTexture, so their mips and
+// BCn blocks are cached.
+class Skybox
+{
+public:
+    explicit Skybox(int shaderID);
+    ~Skybox();
+    Skybox(const Skybox&) = delete;
+    Skybox& operator=(const Skybox&) = delete;
+
+    // +X, -X, +Y, -Y, +Z, -Z. Returns right away, Draw skips frames until all six are decoded
+    void Load(const std::vector<std::string> &faces);
+    // GL thread, uploads the faces once they're decoded
+    void Draw();
+    bool IsReady() const { return texture != 0; }
+
+private:
+    static const int FACE_COUNT = 6;
+
+    int shaderID;
+    GLuint vao = 0;
+    GLuint texture = 0;
+    std::string name;
+    std::vector<std::shared_ptr<const TextureImage>> images; // slot per face, written by the workers
+    std::atomic<int> facesLeft{0};
+
+    // last, so that the workers are joined before anything they touch is destroyed
+    std::unique_ptr<ThreadPool> pool;
+
+    void upload();
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+
+// FNV-1a. constexpr so that names known at build time are hashed by the compiler.
+constexpr uint32_t HashUniformName(const char* str)
+{
+    uint32_t hash = 2166136261u;
+    for(; *str; ++str)
+        hash = (hash ^ uint32_t(uint8_t(*str))) * 16777619u;
+    return hash;
+}
+
+struct UniformName
+{
+    uint32_t hash;
+    const char* str; // not owned, must outlive the lookup
+
+    constexpr UniformName(const char* name)
+        : hash(HashUniformName(name))
+        , str(name)
+    {
+    }
+};
+
+// Resolved once at link time, see Shader::GetUniform
+struct UniformHandle
+{
+    GLint location = -1;
+    GLenum type = GL_NONE;
+    GLint size = 0;
+    // last written bytes live at this offset in the program's shadow, -1 if not shadowed
+    GLint shadowOffset = -1;
+    GLint shadowSize = 0;
+
+    bool IsValid() const { return location != -1; }
+};
+
+// Uniforms set on the hot path. Hashes are computed at compile time.
+namespace Uniforms
+{
+    constexpr UniformName model{"model"};
+    constexpr UniformName meshPositionScale{"meshPositionScale"};
+    constexpr UniformName meshPositionOffset{"meshPositionOffset"};
+    constexpr UniformName color{"color"};
+    constexpr UniformName isSolidColor{"isSolidColor"};
+    constexpr UniformName opaque{"opaque"};
+    constexpr UniformName shininess{"material.shininess"};
+    constexpr UniformName kernel{"kernel"};
+    constexpr UniformName evening{"evening"};
+
+    constexpr int MAX_SAMPLERS_PER_TYPE = 5;
+    constexpr UniformName diffuseSamplers[MAX_SAMPLERS_PER_TYPE] = {
+        "material.texture_diffuse1",
+        "material.texture_diffuse2",
+        "material.texture_diffuse3",
+        "material.texture_diffuse4",
+        "material.texture_diffuse5"};
+    constexpr UniformName specularSamplers[MAX_SAMPLERS_PER_TYPE] = {
+        "material.texture_specular1",
+        "material.texture_specular2",
+        "material.texture_specular3",
+        "material.texture_specular4",
+        "material.texture_specular5"};
+}